@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "TileGridData.h"
+#include "TileSpatialHashLinker.h"
+#include "TileReachability.h"
+#include "TilePathPlanner.h"
+#include "BattleState.h"
+#include "BattleHistory.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTRPGCoreBench, Log, All);
+
+IMPLEMENT_APPLICATION(TRPGCoreBench, "TRPGCoreBench");
+
+// Times Func over Iterations calls and logs the average
+template<typename FuncType>
+static void RunBenchmark(const TCHAR* Name, int32 Iterations, FuncType&& Func)
+{
+	const double startTime = FPlatformTime::Seconds();
+	for (int32 iteration = 0; iteration < Iterations; iteration++)
+	{
+		Func(iteration);
+	}
+	const double elapsedSeconds = FPlatformTime::Seconds() - startTime;
+	UE_LOG(LogTRPGCoreBench, Display, TEXT("%-32s %8d runs %10.2f us/run"), Name, Iterations, elapsedSeconds * 1000000.0 / FMath::Max(Iterations, 1));
+}
+
+// Square map of MapSize x MapSize tiles: mostly plains (terrain 0), some forest (1) and walls (2), and a unit on UnitPercent of the tiles
+static void BuildBattle(int32 MapSize, int32 UnitPercent, FRandomStream& Random, FBattleState& OutState)
+{
+	FTileGridData grid;
+	TArray<FVector> locations;
+	for (int32 x = 0; x < MapSize; x++)
+	{
+		for (int32 y = 0; y < MapSize; y++)
+		{
+			const int32 roll = Random.RandRange(0, 99);
+			grid.AddTile(FIntVector(x, y, 0), roll < 80 ? 0 : (roll < 95 ? 1 : 2));
+			locations.Add(FVector(x * 100.0, y * 100.0, 0.0));
+		}
+	}
+
+	TArray<float> spacings, verticalRanges;
+	spacings.Init(100.0f, locations.Num());
+	verticalRanges.Init(100.0f, locations.Num());
+
+	const double linkStart = FPlatformTime::Seconds();
+	FTileSpatialHashLinker::LinkTiles(locations, spacings, verticalRanges, grid.Neighbors);
+	grid.BuildCellLookup();
+	UE_LOG(LogTRPGCoreBench, Display, TEXT("%-32s %8d tiles %10.2f ms"), TEXT("Link and index tiles"), grid.Num(), (FPlatformTime::Seconds() - linkStart) * 1000.0);
+
+	OutState.Reset();
+	OutState.InitTiles(grid);
+
+	uint8 moveCosts[256];
+	FMemory::Memset(moveCosts, BLOCKED_MOVE_COST, sizeof(moveCosts));
+	moveCosts[0] = 1;
+	moveCosts[1] = 2;
+	OutState.AddMoveCostTable(MakeArrayView(moveCosts));
+
+	for (int32 tileIndex = 0; tileIndex < grid.Num(); tileIndex++)
+	{
+		if (grid.TerrainTypes[tileIndex] != 2 && Random.RandRange(0, 99) < UnitPercent)
+		{
+			FBattleUnit unit;
+			unit.Tile = tileIndex;
+			unit.Faction = Random.RandRange(0, 1) ? BATTLE_FACTION_PLAYER : BATTLE_FACTION_ENEMY;
+			unit.BaseMovementSpaces = 6;
+			unit.MinActRange = 1;
+			unit.MaxActRange = Random.RandRange(1, 3);
+			unit.bTargetsEnemies = true;
+			OutState.AddUnit(unit);
+		}
+	}
+	OutState.AdvancePhase();
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	FTaskTagScope scope(ETaskTag::EGameThread);
+	ON_SCOPE_EXIT
+	{
+		LLM(FLowLevelMemTracker::Get().UpdateStatsPerFrame());
+		RequestEngineExit(TEXT("Exiting"));
+		FEngineLoop::AppPreExit();
+		FModuleManager::Get().UnloadModulesAtShutdown();
+		FEngineLoop::AppExit();
+	};
+
+	if (int32 result = GEngineLoop.PreInit(ArgC, ArgV))
+	{
+		return result;
+	}
+
+	// -MapSize=N -Units=percent -Runs=N
+	int32 mapSize = 128, unitPercent = 5, runs = 1000;
+	FParse::Value(FCommandLine::Get(), TEXT("-MapSize="), mapSize);
+	FParse::Value(FCommandLine::Get(), TEXT("-Units="), unitPercent);
+	FParse::Value(FCommandLine::Get(), TEXT("-Runs="), runs);
+
+	FRandomStream random(1234);	// fixed seed - every run measures the same map
+	FBattleState battle;
+	BuildBattle(mapSize, unitPercent, random, battle);
+	const FTileGridData& grid = battle.Grid;
+	UE_LOG(LogTRPGCoreBench, Display, TEXT("%d x %d map, %d units"), mapSize, mapSize, battle.Units.Num());
+	if (battle.Units.IsEmpty())
+	{
+		return 0;
+	}
+
+	TArray<int32> sourceTiles;
+	for (int32 unitIndex = 0; unitIndex < battle.Units.Num(); unitIndex++)
+	{
+		sourceTiles.Add(battle.Units[unitIndex].Tile);
+	}
+
+	FTileReachabilityEngine engine;
+	FTileReachabilityResult result;
+	RunBenchmark(TEXT("Reachability (move 6, range 1-3)"), runs, [&](int32 Run)
+		{
+			FTileReachabilityQuery query;
+			battle.MakeUnitQuery(Run % battle.Units.Num(), query);
+			query.MoveBudget = 6;
+			query.MinActRange = 1;
+			query.MaxActRange = 3;
+			query.bTargetsEnemies = true;
+			engine.Compute(grid, query, result);
+		});
+
+	FTilePathPlanner planner;
+	TArray<int32> path;
+	RunBenchmark(TEXT("Path (budget 12)"), runs, [&](int32 Run)
+		{
+			FTilePathQuery query;
+			query.FromTile = sourceTiles[Run % sourceTiles.Num()];
+			query.ToTile = FMath::Clamp(query.FromTile + (Run % 7) - 3 + ((Run % 5) - 2) * mapSize, 0, grid.Num() - 1);
+			query.MoveBudget = 12;
+			query.MoveCosts = TConstArrayView<uint8>(battle.MoveCostTables.GetData(), 256);
+			int32 cost;
+			planner.FindPath(grid, query, path, cost);
+		});
+
+	TArray<int32> foundTiles;
+	RunBenchmark(TEXT("Ring unit query (range 1-3)"), runs, [&](int32 Run)
+		{
+			foundTiles.Reset();
+			grid.FindOccupiedTilesInRange(sourceTiles[Run % sourceTiles.Num()], 1, 3, 1u << BATTLE_FACTION_ENEMY, foundTiles);
+		});
+
+	const int32 batchSize = FMath::Min(20, sourceTiles.Num());
+	RunBenchmark(TEXT("Batched ring query (20 sources)"), runs, [&](int32 Run)
+		{
+			foundTiles.Reset();
+			const int32 firstSource = Run % (sourceTiles.Num() - batchSize + 1);
+			grid.FindOccupiedTilesInRange(TConstArrayView<int32>(sourceTiles.GetData() + firstSource, batchSize), 1, 3, 1u << BATTLE_FACTION_ENEMY, foundTiles);
+		});
+
+	FBattleState copy;
+	RunBenchmark(TEXT("Battle state copy"), runs, [&](int32 Run)
+		{
+			copy = battle;
+		});
+
+	// Every unit of the active faction moves to the farthest tile it can stop on, then the phase advances
+	RunBenchmark(TEXT("Battle phase step"), FMath::Max(runs / 100, 1), [&](int32 Run)
+		{
+			for (int32 unitIndex = 0; unitIndex < battle.Units.Num(); unitIndex++)
+			{
+				if (battle.Units[unitIndex].Faction != battle.ActiveFaction || !battle.Units[unitIndex].IsInBattle())
+				{
+					continue;
+				}
+				battle.ComputeReachability(unitIndex, engine, result);
+				for (int32 slot = result.NavigableTiles.Num() - 1; slot > 0; slot--)
+				{
+					if (battle.MoveUnit(unitIndex, result.NavigableTiles[slot], engine))
+					{
+						break;
+					}
+				}
+				battle.CompleteUnitAction(unitIndex, false, 0);
+			}
+			battle.AdvancePhase();
+		});
+
+	// Same phase steps with a history snapshot after every action, then restores of snapshots spread over the history
+	FBattleHistory history;
+	history.TakeSnapshot(battle);
+	const double historyStart = FPlatformTime::Seconds();
+	for (int32 phase = 0; phase < 8; phase++)
+	{
+		for (int32 unitIndex = 0; unitIndex < battle.Units.Num(); unitIndex++)
+		{
+			if (battle.Units[unitIndex].Faction != battle.ActiveFaction || !battle.Units[unitIndex].IsInBattle())
+			{
+				continue;
+			}
+			battle.ComputeReachability(unitIndex, engine, result);
+			if (result.NavigableTiles.Num() > 1)
+			{
+				battle.MoveUnit(unitIndex, result.NavigableTiles.Last(), engine);
+			}
+			battle.CompleteUnitAction(unitIndex, false, 0);
+			history.TakeSnapshot(battle);
+		}
+		battle.AdvancePhase();
+		history.TakeSnapshot(battle);
+	}
+	UE_LOG(LogTRPGCoreBench, Display, TEXT("%-32s %8d snapshots %10.2f ms %10.2f KB"), TEXT("Battle history (8 phases)"), history.Num(),
+		(FPlatformTime::Seconds() - historyStart) * 1000.0, history.GetAllocatedSize() / 1024.0);
+
+	RunBenchmark(TEXT("History snapshot restore"), runs, [&](int32 Run)
+		{
+			history.RestoreSnapshot((Run * 7919) % history.Num(), copy);
+		});
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+// Console program that times the TRPGCore algorithms on generated maps. Links Core and TRPGCore only, so it starts in milliseconds.
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class TRPGCoreBenchTarget : TargetRules
+{
+	public TRPGCoreBenchTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "TRPGCoreBench";
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
+
+		bBuildDeveloperTools = false;
+		bCompileWithEditorOnlyData = false;
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+	}
+}
@@ -0,0 +1,566 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "TileGridData.h"
+#include "TileRowMask.h"
+#include "TileSpatialHashLinker.h"
+#include "TileReachability.h"
+#include "TilePathPlanner.h"
+#include "BattleState.h"
+#include "BattleHistory.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTRPGCoreTests, Log, All);
+
+IMPLEMENT_APPLICATION(TRPGCoreTests, "TRPGCoreTests");
+
+static int32 GFailedChecks = 0;
+
+// Logs a failed expectation and keeps going, so one run reports every failure
+#define TEST_CHECK(Expr) \
+	do \
+	{ \
+		if (!(Expr)) \
+		{ \
+			UE_LOG(LogTRPGCoreTests, Error, TEXT("%s(%d): check failed: %s"), ANSI_TO_TCHAR(__FILE__), __LINE__, ANSI_TO_TCHAR(#Expr)); \
+			GFailedChecks++; \
+		} \
+	} while (0)
+
+// Helpers
+
+// Builds a flat map from rows of characters: '.' plains (terrain 0), 'f' forest (1), '#' wall (2).
+// Row i holds the tiles at X = i, character j the tile at Y = j. Neighbors are linked by FTileSpatialHashLinker.
+static void BuildGrid(TConstArrayView<const TCHAR*> Rows, FTileGridData& OutGrid)
+{
+	OutGrid.Reset();
+	TArray<FVector> locations;
+	for (int32 x = 0; x < Rows.Num(); x++)
+	{
+		for (int32 y = 0; Rows[x][y] != 0; y++)
+		{
+			const TCHAR symbol = Rows[x][y];
+			OutGrid.AddTile(FIntVector(x, y, 0), symbol == TEXT('f') ? 1 : (symbol == TEXT('#') ? 2 : 0));
+			locations.Add(FVector(x * 100.0, y * 100.0, 0.0));
+		}
+	}
+
+	TArray<float> spacings, verticalRanges;
+	spacings.Init(100.0f, locations.Num());
+	verticalRanges.Init(100.0f, locations.Num());
+	FTileSpatialHashLinker::LinkTiles(locations, spacings, verticalRanges, OutGrid.Neighbors);
+	OutGrid.BuildCellLookup();
+}
+
+static int32 FindTile(const FTileGridData& Grid, int32 X, int32 Y)
+{
+	for (int32 tileIndex = 0; tileIndex < Grid.Num(); tileIndex++)
+	{
+		if (Grid.Coords[tileIndex] == FIntVector(X, Y, 0))
+		{
+			return tileIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+// Plains 1, forest 2, walls blocked
+static void MakeMoveCosts(uint8 (&OutMoveCosts)[256])
+{
+	FMemory::Memset(OutMoveCosts, BLOCKED_MOVE_COST, sizeof(OutMoveCosts));
+	OutMoveCosts[0] = 1;
+	OutMoveCosts[1] = 2;
+}
+
+static int32 GetManhattanDistance(const FTileGridData& Grid, int32 TileA, int32 TileB)
+{
+	return FMath::Abs(Grid.Coords[TileA].X - Grid.Coords[TileB].X) + FMath::Abs(Grid.Coords[TileA].Y - Grid.Coords[TileB].Y);
+}
+
+// Cheapest movement from StartTile to every tile by repeated relaxation over tile coordinates, without the neighbor arrays.
+// Tiles held by a blocking faction cannot be entered. INDEX_NONE when unreachable.
+static void GetReferenceDistances(const FTileGridData& Grid, int32 StartTile, TConstArrayView<uint8> MoveCosts, uint32 BlockingFactions, TArray<int32>& OutDistances)
+{
+	OutDistances.Init(INDEX_NONE, Grid.Num());
+	OutDistances[StartTile] = 0;
+	for (bool changed = true; changed; )
+	{
+		changed = false;
+		for (int32 tileIndex = 0; tileIndex < Grid.Num(); tileIndex++)
+		{
+			if (OutDistances[tileIndex] == INDEX_NONE)
+			{
+				continue;
+			}
+			for (int32 nextIndex = 0; nextIndex < Grid.Num(); nextIndex++)
+			{
+				const uint8 moveCost = MoveCosts[Grid.TerrainTypes[nextIndex]];
+				if (GetManhattanDistance(Grid, tileIndex, nextIndex) != 1 || moveCost == BLOCKED_MOVE_COST || (BlockingFactions & (1u << Grid.OccupantFactions[nextIndex])))
+				{
+					continue;
+				}
+				const int32 distance = OutDistances[tileIndex] + moveCost;
+				if (OutDistances[nextIndex] == INDEX_NONE || distance < OutDistances[nextIndex])
+				{
+					OutDistances[nextIndex] = distance;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+// True if Path is a walk of neighboring tiles from FromTile whose entry costs add up to Cost
+static bool IsValidPath(const FTileGridData& Grid, int32 FromTile, TConstArrayView<int32> Path, TConstArrayView<uint8> MoveCosts, int32 Cost)
+{
+	int32 pathCost = 0;
+	int32 previousTile = FromTile;
+	for (int32 tileIndex : Path)
+	{
+		if (GetManhattanDistance(Grid, previousTile, tileIndex) != 1 || MoveCosts[Grid.TerrainTypes[tileIndex]] == BLOCKED_MOVE_COST)
+		{
+			return false;
+		}
+		pathCost += MoveCosts[Grid.TerrainTypes[tileIndex]];
+		previousTile = tileIndex;
+	}
+	return pathCost == Cost;
+}
+
+// Re-plans a path the slow way - one FindPath per prefix, longest first, each detour avoiding only its own prefix.
+// Returns the prefix length and detour cost, or INDEX_NONE for the prefix length if no prefix fits.
+static void GetReferencePrefixSplit(const FTileGridData& Grid, const FTilePathQuery& Query, TConstArrayView<int32> Path, int32& OutPrefixLength, int32& OutDetourCost)
+{
+	OutPrefixLength = INDEX_NONE;
+	OutDetourCost = 0;
+	FTilePathPlanner planner;
+	for (int32 prefixEnd = Path.Num() - 1; prefixEnd >= 0; prefixEnd--)
+	{
+		int32 prefixCost = 0;
+		FTileBitset prefixTiles(Grid.Num());
+		for (int32 i = 0; i < prefixEnd; i++)
+		{
+			prefixCost += Query.GetTileCost(Grid, Path[i + 1]);
+			prefixTiles.Add(Path[i]);
+		}
+		if (prefixCost > Query.MoveBudget)
+		{
+			continue;
+		}
+
+		FTilePathQuery detourQuery = Query;
+		detourQuery.FromTile = Path[prefixEnd];
+		detourQuery.MoveBudget = Query.MoveBudget - prefixCost;
+		detourQuery.ExcludedTiles = &prefixTiles;
+		TArray<int32> detour;
+		if (planner.FindPath(Grid, detourQuery, detour, OutDetourCost))
+		{
+			OutPrefixLength = prefixEnd + 1;
+			return;
+		}
+	}
+}
+
+static bool AreMasksEqual(const FTileRowMask& A, const FTileRowMask& B)
+{
+	if (A.GetSize() != B.GetSize())
+	{
+		return false;
+	}
+	const int32 wordCount = A.GetSize().X * A.GetWordsPerRow();
+	return wordCount == 0 || FMemory::Memcmp(A.GetRow(0), B.GetRow(0), wordCount * sizeof(uint64)) == 0;
+}
+
+static bool AreBattlesEqual(const FBattleState& A, const FBattleState& B)
+{
+	if (A.Units.Num() != B.Units.Num() || (A.Units.Num() && FMemory::Memcmp(A.Units.GetData(), B.Units.GetData(), A.Units.Num() * sizeof(FBattleUnit)) != 0))
+	{
+		return false;
+	}
+	for (int32 faction = 0; faction < OCCUPANT_FACTION_COUNT; faction++)
+	{
+		if (!AreMasksEqual(A.Grid.FactionCells[faction], B.Grid.FactionCells[faction]))
+		{
+			return false;
+		}
+	}
+	return A.TileUnits == B.TileUnits && A.Grid.OccupantFactions == B.Grid.OccupantFactions && A.Grid.TerrainTypes == B.Grid.TerrainTypes
+		&& A.MoveCostTables == B.MoveCostTables && A.ActiveFaction == B.ActiveFaction && A.RoundNumber == B.RoundNumber;
+}
+
+// Tests
+
+static void TestSpatialHashLinker()
+{
+	// Every neighbor of a flat map is the tile one spacing away, and edges have none
+	const TCHAR* rows[] = { TEXT("...."), TEXT("...."), TEXT("....") };
+	FTileGridData grid;
+	BuildGrid(MakeArrayView(rows), grid);
+	for (int32 tileIndex = 0; tileIndex < grid.Num(); tileIndex++)
+	{
+		const FIntVector& coord = grid.Coords[tileIndex];
+		TEST_CHECK(grid.GetNeighbor(tileIndex, NEIGHBOR_NORTH) == FindTile(grid, coord.X + 1, coord.Y));
+		TEST_CHECK(grid.GetNeighbor(tileIndex, NEIGHBOR_SOUTH) == FindTile(grid, coord.X - 1, coord.Y));
+		TEST_CHECK(grid.GetNeighbor(tileIndex, NEIGHBOR_EAST) == FindTile(grid, coord.X, coord.Y + 1));
+		TEST_CHECK(grid.GetNeighbor(tileIndex, NEIGHBOR_WEST) == FindTile(grid, coord.X, coord.Y - 1));
+	}
+
+	// Heights: within half the vertical range links, the lowest candidate wins, and a tile far above does not link
+	const FVector locations[] = { FVector(0.0, 0.0, 0.0), FVector(100.0, 0.0, -40.0), FVector(100.0, 0.0, 40.0), FVector(0.0, 100.0, 300.0), FVector(0.0, -100.0, 45.0) };
+	TArray<float> spacings, verticalRanges;
+	spacings.Init(100.0f, UE_ARRAY_COUNT(locations));
+	verticalRanges.Init(100.0f, UE_ARRAY_COUNT(locations));
+	TArray<int32> neighbors[NEIGHBOR_COUNT];
+	FTileSpatialHashLinker::LinkTiles(MakeArrayView(locations), spacings, verticalRanges, neighbors);
+	TEST_CHECK(neighbors[NEIGHBOR_NORTH][0] == 1);
+	TEST_CHECK(neighbors[NEIGHBOR_EAST][0] == INDEX_NONE);
+	TEST_CHECK(neighbors[NEIGHBOR_WEST][0] == 4);
+	TEST_CHECK(neighbors[NEIGHBOR_SOUTH][1] == 0);
+	TEST_CHECK(neighbors[NEIGHBOR_SOUTH][2] == 0);
+	TEST_CHECK(neighbors[NEIGHBOR_WEST][3] == INDEX_NONE);
+
+	// Off-grid jitter within half a spacing still links
+	const FVector jittered[] = { FVector(0.0, 0.0, 0.0), FVector(130.0, -20.0, 0.0) };
+	TArray<int32> jitterNeighbors[NEIGHBOR_COUNT];
+	FTileSpatialHashLinker::LinkTiles(MakeArrayView(jittered), MakeArrayView(spacings.GetData(), 2), MakeArrayView(verticalRanges.GetData(), 2), jitterNeighbors);
+	TEST_CHECK(jitterNeighbors[NEIGHBOR_NORTH][0] == 1);
+	TEST_CHECK(jitterNeighbors[NEIGHBOR_SOUTH][1] == 0);
+}
+
+static void TestReachability()
+{
+	const TCHAR* rows[] = { TEXT("......"), TEXT(".f#..."), TEXT(".ff.#."), TEXT("......") };
+	FTileGridData grid;
+	BuildGrid(MakeArrayView(rows), grid);
+	uint8 moveCosts[256];
+	MakeMoveCosts(moveCosts);
+
+	const int32 startTile = FindTile(grid, 0, 0);
+	const int32 allyTile = FindTile(grid, 0, 1);
+	const int32 enemyTile = FindTile(grid, 3, 1);
+	grid.SetOccupantFaction(allyTile, BATTLE_FACTION_PLAYER);
+	grid.SetOccupantFaction(enemyTile, BATTLE_FACTION_ENEMY);
+
+	FTileReachabilityEngine engine;
+	FTileReachabilityResult result;
+	for (int32 budget = 0; budget <= 8; budget++)
+	{
+		FTileReachabilityQuery query;
+		query.StartTile = startTile;
+		query.MoveBudget = budget;
+		query.MoveCosts = MakeArrayView(moveCosts);
+		query.HostileFactions = 1u << BATTLE_FACTION_ENEMY;
+		query.AlliedFactions = 1u << BATTLE_FACTION_PLAYER;
+		engine.Compute(grid, query, result);
+
+		// Exactly the tiles within the budget, at their cheapest distance - a tile at the budget is in, one past it is out
+		TArray<int32> reference;
+		GetReferenceDistances(grid, startTile, MakeArrayView(moveCosts), query.HostileFactions, reference);
+		for (int32 tileIndex = 0; tileIndex < grid.Num(); tileIndex++)
+		{
+			const int32 expected = reference[tileIndex] != INDEX_NONE && reference[tileIndex] <= budget ? reference[tileIndex] : INDEX_NONE;
+			TEST_CHECK(result.GetDistance(tileIndex) == expected);
+
+			TArray<int32> route;
+			result.GetPathTo(tileIndex, route);
+			if (expected != INDEX_NONE)
+			{
+				TEST_CHECK(route.Num() > 0 && route[0] == startTile && IsValidPath(grid, startTile, TConstArrayView<int32>(route.GetData() + 1, route.Num() - 1), MakeArrayView(moveCosts), expected));
+			}
+		}
+	}
+
+	// Allies are passed through, the enemy is not
+	FTileReachabilityQuery query;
+	query.StartTile = startTile;
+	query.MoveBudget = 2;
+	query.MoveCosts = MakeArrayView(moveCosts);
+	query.HostileFactions = 1u << BATTLE_FACTION_ENEMY;
+	engine.Compute(grid, query, result);
+	TEST_CHECK(result.GetDistance(FindTile(grid, 0, 2)) == 2);
+	TEST_CHECK(!result.IsNavigable(enemyTile));
+
+	// Attackable tiles are the enemies within weapon range of a tile the unit can stop on
+	query.MoveBudget = 3;
+	query.MinActRange = 1;
+	query.MaxActRange = 1;
+	query.bTargetsEnemies = true;
+	engine.Compute(grid, query, result);
+	TEST_CHECK(result.AttackableTiles.Num() == 1 && result.AttackableTiles[0] == enemyTile);	// (3, 0) is 3 away and next to the enemy
+
+	query.MoveBudget = 2;
+	engine.Compute(grid, query, result);
+	TEST_CHECK(result.AttackableTiles.IsEmpty());
+
+	query.MaxActRange = 3;
+	engine.Compute(grid, query, result);
+	TEST_CHECK(result.AttackableTiles.Num() == 1 && result.AttackableTiles[0] == enemyTile);
+
+	query.MinActRange = 5;
+	query.MaxActRange = 6;
+	engine.Compute(grid, query, result);
+	TEST_CHECK(result.AttackableTiles.IsEmpty());
+}
+
+static void TestPathPlanner()
+{
+	const TCHAR* rows[] = { TEXT("......"), TEXT(".f#..."), TEXT(".ff.#."), TEXT("......") };
+	FTileGridData grid;
+	BuildGrid(MakeArrayView(rows), grid);
+	uint8 moveCosts[256];
+	MakeMoveCosts(moveCosts);
+
+	// Every reachable pair gets a valid path at exactly the cheapest cost, and none with one movement less
+	FTilePathPlanner planner;
+	TArray<int32> path;
+	for (int32 fromTile = 0; fromTile < grid.Num(); fromTile++)
+	{
+		TArray<int32> reference;
+		GetReferenceDistances(grid, fromTile, MakeArrayView(moveCosts), 0, reference);
+		for (int32 toTile = 0; toTile < grid.Num(); toTile++)
+		{
+			if (reference[toTile] == INDEX_NONE || fromTile == toTile)
+			{
+				continue;
+			}
+
+			FTilePathQuery query;
+			query.FromTile = fromTile;
+			query.ToTile = toTile;
+			query.MoveBudget = reference[toTile];
+			query.MoveCosts = MakeArrayView(moveCosts);
+			int32 cost = INDEX_NONE;
+			TEST_CHECK(planner.FindPath(grid, query, path, cost));
+			TEST_CHECK(cost == reference[toTile] && path.Num() && path.Last() == toTile && IsValidPath(grid, fromTile, path, MakeArrayView(moveCosts), cost));
+
+			query.MoveBudget = reference[toTile] - 1;
+			TEST_CHECK(!planner.FindPath(grid, query, path, cost));
+		}
+	}
+
+	// Re-planning a drawn path
+	const TCHAR* smallRows[] = { TEXT(".."), TEXT(".."), TEXT("..") };
+	FTileGridData smallGrid;
+	BuildGrid(MakeArrayView(smallRows), smallGrid);
+	const int32 a = FindTile(smallGrid, 0, 0), b = FindTile(smallGrid, 0, 1), c = FindTile(smallGrid, 1, 1), d = FindTile(smallGrid, 1, 0), x = FindTile(smallGrid, 2, 0);
+
+	FTilePathQuery query;
+	query.MoveCosts = MakeArrayView(moveCosts);
+	query.MoveBudget = 3;
+	int32 prefixLength;
+	TArray<int32> detour;
+
+	// Extending the path by one tile keeps all of it
+	const int32 shortPath[] = { a, b };
+	query.ToTile = c;
+	TEST_CHECK(planner.FindPathKeepingPrefix(smallGrid, query, MakeArrayView(shortPath), prefixLength, detour));
+	TEST_CHECK(prefixLength == 2 && detour.Num() == 1 && detour[0] == c);
+
+	// A -> B -> C -> D, then X: the only route in budget goes back through D, which is on the dropped tail of the path
+	const int32 loopPath[] = { a, b, c, d };
+	query.ToTile = x;
+	TEST_CHECK(planner.FindPathKeepingPrefix(smallGrid, query, MakeArrayView(loopPath), prefixLength, detour));
+	TEST_CHECK(prefixLength == 1 && detour.Num() == 2 && detour[0] == d && detour[1] == x);
+
+	// Hovering a tile already on the path cuts the path back to it
+	query.ToTile = b;
+	TEST_CHECK(planner.FindPathKeepingPrefix(smallGrid, query, MakeArrayView(loopPath), prefixLength, detour));
+	TEST_CHECK(prefixLength == 2 && detour.IsEmpty());
+
+	// Out of budget from every prefix
+	query.MoveBudget = 1;
+	query.ToTile = x;
+	TEST_CHECK(!planner.FindPathKeepingPrefix(smallGrid, query, MakeArrayView(loopPath), prefixLength, detour));
+
+	// Random walks on the larger map match a search per prefix in kept length and detour cost, and the detour avoids the kept prefix
+	FRandomStream random(1234);
+	query.MoveCosts = MakeArrayView(moveCosts);
+	for (int32 trial = 0; trial < 2000; trial++)
+	{
+		TArray<int32> walk;
+		walk.Add(random.RandRange(0, grid.Num() - 1));
+		const int32 walkLength = random.RandRange(0, 6);
+		for (int32 step = 0; step < walkLength; step++)
+		{
+			const int32 nextTile = grid.GetNeighbor(walk.Last(), (ETileNeighbor)random.RandRange(0, NEIGHBOR_COUNT - 1));
+			if (nextTile != INDEX_NONE && !walk.Contains(nextTile) && moveCosts[grid.TerrainTypes[nextTile]] != BLOCKED_MOVE_COST)
+			{
+				walk.Add(nextTile);
+			}
+		}
+		query.ToTile = random.RandRange(0, grid.Num() - 1);
+		query.MoveBudget = random.RandRange(0, 12);
+
+		int32 referenceLength, referenceCost;
+		GetReferencePrefixSplit(grid, query, walk, referenceLength, referenceCost);
+		const bool bFound = planner.FindPathKeepingPrefix(grid, query, walk, prefixLength, detour);
+		TEST_CHECK(bFound == (referenceLength != INDEX_NONE));
+		if (bFound && referenceLength != INDEX_NONE)
+		{
+			int32 detourCost = 0;
+			for (int32 tileIndex : detour)
+			{
+				detourCost += moveCosts[grid.TerrainTypes[tileIndex]];
+			}
+			TEST_CHECK(prefixLength == referenceLength && detourCost == referenceCost);
+			TEST_CHECK(IsValidPath(grid, walk[prefixLength - 1], detour, MakeArrayView(moveCosts), detourCost));
+			TEST_CHECK(detour.IsEmpty() ? walk[prefixLength - 1] == query.ToTile : detour.Last() == query.ToTile);
+			for (int32 i = 0; i < prefixLength; i++)
+			{
+				TEST_CHECK(!detour.Contains(walk[i]));
+			}
+		}
+	}
+}
+
+static void TestDilateAnnulus()
+{
+	FRandomStream random(4321);
+	const FIntPoint sizes[] = { FIntPoint(7, 9), FIntPoint(5, 130), FIntPoint(66, 3), FIntPoint(1, 64) };
+	const FIntPoint ranges[] = { FIntPoint(0, 0), FIntPoint(1, 1), FIntPoint(1, 3), FIntPoint(2, 5), FIntPoint(0, 70), FIntPoint(4, 2) };
+	for (const FIntPoint& size : sizes)
+	{
+		FTileRowMask source;
+		source.Init(size);
+		for (int32 cell = 0; cell < size.X * size.Y; cell++)
+		{
+			if (random.RandRange(0, 99) < 4)
+			{
+				source.Add(cell);
+			}
+		}
+
+		for (const FIntPoint& range : ranges)
+		{
+			FTileRowMask result;
+			FTileRowMask::DilateAnnulus(source, range.X, range.Y, result);
+
+			int32 mismatches = 0;
+			for (int32 cell = 0; cell < size.X * size.Y; cell++)
+			{
+				bool expected = false;
+				for (int32 sourceCell = 0; sourceCell < size.X * size.Y && !expected; sourceCell++)
+				{
+					const int32 distance = FMath::Abs(cell / size.Y - sourceCell / size.Y) + FMath::Abs(cell % size.Y - sourceCell % size.Y);
+					expected = source.Contains(sourceCell) && distance >= range.X && distance <= range.Y;
+				}
+				mismatches += result.Contains(cell) != expected;
+			}
+			TEST_CHECK(mismatches == 0);
+		}
+	}
+}
+
+static void TestBattleHistory()
+{
+	// 20 x 20 plains with 140 units in a checkerboard over the first 14 rows - three pages of units
+	FTileGridData grid;
+	for (int32 x = 0; x < 20; x++)
+	{
+		for (int32 y = 0; y < 20; y++)
+		{
+			grid.AddTile(FIntVector(x, y, 0), 0);
+		}
+	}
+	for (int32 tileIndex = 0; tileIndex < grid.Num(); tileIndex++)
+	{
+		const FIntVector& coord = grid.Coords[tileIndex];
+		grid.Neighbors[NEIGHBOR_NORTH][tileIndex] = coord.X < 19 ? tileIndex + 20 : INDEX_NONE;
+		grid.Neighbors[NEIGHBOR_SOUTH][tileIndex] = coord.X > 0 ? tileIndex - 20 : INDEX_NONE;
+		grid.Neighbors[NEIGHBOR_EAST][tileIndex] = coord.Y < 19 ? tileIndex + 1 : INDEX_NONE;
+		grid.Neighbors[NEIGHBOR_WEST][tileIndex] = coord.Y > 0 ? tileIndex - 1 : INDEX_NONE;
+	}
+	grid.BuildCellLookup();
+
+	FBattleState battle;
+	battle.InitTiles(grid);
+	uint8 moveCosts[256];
+	MakeMoveCosts(moveCosts);
+	battle.AddMoveCostTable(MakeArrayView(moveCosts));
+	for (int32 tileIndex = 0; tileIndex < 14 * 20; tileIndex++)
+	{
+		if ((grid.Coords[tileIndex].X + grid.Coords[tileIndex].Y) % 2 == 0)
+		{
+			FBattleUnit unit;
+			unit.Tile = tileIndex;
+			unit.Faction = battle.Units.Num() % 2 ? BATTLE_FACTION_ENEMY : BATTLE_FACTION_PLAYER;
+			unit.BaseMovementSpaces = 2;
+			TEST_CHECK(battle.AddUnit(unit) != INDEX_NONE);
+		}
+	}
+	TEST_CHECK(battle.Units.Num() == 140);
+	battle.AdvancePhase();
+
+	FBattleHistory history;
+	TEST_CHECK(history.TakeSnapshot(battle) == 0);
+	const FBattleState start = battle;
+
+	// Unit 0 moves one tile and acts - only the first page of units changes
+	FTileReachabilityEngine engine;
+	TEST_CHECK(battle.MoveUnit(0, battle.Units[0].Tile + 1, engine));
+	battle.CompleteUnitAction(0, false, 0);
+	TEST_CHECK(history.TakeSnapshot(battle) == 1);
+	const FBattleState moved = battle;
+
+	const FBattleSnapshot first = history.GetSnapshot(0);	// copies share the pages - the snapshot array may move as it grows
+	const FBattleSnapshot second = history.GetSnapshot(1);
+	TEST_CHECK(first.Units->Pages.Num() == 3 && second.Units->Pages.Num() == 3);
+	TEST_CHECK(&first.Units->Pages[0].Get() != &second.Units->Pages[0].Get());
+	TEST_CHECK(&first.Units->Pages[1].Get() == &second.Units->Pages[1].Get() && &first.Units->Pages[2].Get() == &second.Units->Pages[2].Get());
+	TEST_CHECK(first.MoveCostTables.Get() == second.MoveCostTables.Get());
+
+	// An enemy in the last page is defeated and the phase moves on
+	battle.RemoveUnit(139);
+	battle.AdvancePhase();
+	TEST_CHECK(history.TakeSnapshot(battle) == 2);
+	const FBattleState defeated = battle;
+	TEST_CHECK(&history.GetSnapshot(2).Units->Pages[0].Get() != &second.Units->Pages[0].Get());	// the new phase reset every enemy
+
+	// Every snapshot restores exactly, in any order, onto the live state or an empty one
+	TEST_CHECK(history.RestoreSnapshot(0, battle) && AreBattlesEqual(battle, start));
+	TEST_CHECK(history.RestoreSnapshot(2, battle) && AreBattlesEqual(battle, defeated));
+	TEST_CHECK(history.RestoreSnapshot(1, battle) && AreBattlesEqual(battle, moved));
+
+	FBattleState fresh;
+	TEST_CHECK(history.RestoreSnapshot(2, fresh) && AreBattlesEqual(fresh, defeated));
+	TEST_CHECK(fresh.CountUnits(BATTLE_FACTION_ENEMY) == 69 && fresh.GetUnitOnTile(start.Units[139].Tile) == INDEX_NONE);
+
+	TEST_CHECK(!history.RestoreSnapshot(3, battle));
+
+	// Branching after a rewind drops the undone snapshots
+	history.TruncateSnapshots(2);
+	TEST_CHECK(history.Num() == 2);
+	TEST_CHECK(history.RestoreSnapshot(1, battle) && AreBattlesEqual(battle, moved));
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	FTaskTagScope scope(ETaskTag::EGameThread);
+	ON_SCOPE_EXIT
+	{
+		LLM(FLowLevelMemTracker::Get().UpdateStatsPerFrame());
+		RequestEngineExit(TEXT("Exiting"));
+		FEngineLoop::AppPreExit();
+		FModuleManager::Get().UnloadModulesAtShutdown();
+		FEngineLoop::AppExit();
+	};
+
+	if (int32 result = GEngineLoop.PreInit(ArgC, ArgV))
+	{
+		return result;
+	}
+
+	TestSpatialHashLinker();
+	TestReachability();
+	TestPathPlanner();
+	TestDilateAnnulus();
+	TestBattleHistory();
+
+	if (GFailedChecks > 0)
+	{
+		UE_LOG(LogTRPGCoreTests, Error, TEXT("%d checks failed"), GFailedChecks);
+		return 1;
+	}
+	UE_LOG(LogTRPGCoreTests, Display, TEXT("All checks passed"));
+	return 0;
+}
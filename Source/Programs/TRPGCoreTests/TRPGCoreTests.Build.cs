@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class TRPGCoreTests : ModuleRules
+{
+	public TRPGCoreTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Public"));
+		PrivateIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Private"));	// RequiredProgramMainCPPInclude.h
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "Projects", "TRPGCore" });
+	}
+}
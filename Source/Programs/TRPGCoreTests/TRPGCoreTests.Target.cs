@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+// Console program that checks the TRPGCore algorithms against brute-force references on small maps. Exits non-zero when a check fails.
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class TRPGCoreTestsTarget : TargetRules
+{
+	public TRPGCoreTestsTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "TRPGCoreTests";
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
+
+		bBuildDeveloperTools = false;
+		bCompileWithEditorOnlyData = false;
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+	}
+}
@@ -4,11 +4,22 @@
 #include "CombatGameMode.h"
 #include "TileControlPawn.h"
 #include "EventDataActor.h"
+#include "TileReachabilitySubsystem.h"
+#include "UnitRegistrySubsystem.h"
+#include "TileGridSubsystem.h"
+#include "TerrainInfoSubsystem.h"
+#include "MovementClassAsset.h"
+#include "BattleState.h"
 
 void ACombatGameMode::BeginPlay()
 {
 	Super::BeginPlay();
 
+	bFastForward |= FParse::Param(FCommandLine::Get(), TEXT("TRPGFastForward"));
+	if (bFastForward)
+	{
+		SimStartTime = FPlatformTime::Seconds();
+	}
 }
 
 void ACombatGameMode::BeginFirstPhase()
@@ -119,12 +130,226 @@ void ACombatGameMode::EndPauseForEvent()
 
 ATileControlPawn* ACombatGameMode::GetControlPawn()
 {
-	auto* tileControlPawn = UGameplayStatics::GetActorOfClass(GetWorld(), ATileControlPawn::StaticClass());
-	if (tileControlPawn)
+	if (!IsValid(ControlPawn))
+	{
+		// searched once - the pawn lives as long as the level
+		ControlPawn = Cast<ATileControlPawn>(UGameplayStatics::GetActorOfClass(GetWorld(), ATileControlPawn::StaticClass()));
+	}
+	return ControlPawn;
+}
+
+bool ACombatGameMode::IsFastForwardBattle(const UObject* WorldContextObject)
+{
+	UWorld* world = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	auto* combatGameMode = world ? Cast<ACombatGameMode>(world->GetAuthGameMode()) : nullptr;
+	return combatGameMode && combatGameMode->bFastForward;
+}
+
+void ACombatGameMode::CaptureBattleState(FBattleState& OutState, TArray<AGameUnit*>& InOutUnitActors)
+{
+	auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>();
+	if (!tileGrid || !registry)
+	{
+		OutState.Reset();
+		InOutUnitActors.Reset();
+		return;
+	}
+
+	const FTileGridData& gridData = tileGrid->GetGridData();
+	if (OutState.Grid.HasSameLayout(gridData) && OutState.TileUnits.Num() == gridData.Num())
+	{
+		OutState.ClearUnits();	// same map - the tile graph and terrain are kept, only what an action changes is copied
+		OutState.MoveCostTables.Reset();
+	}
+	else
+	{
+		OutState.Reset();
+		OutState.InitTiles(gridData);
+	}
+	OutState.ActiveFaction = GetPhaseFaction(CurrentCombatPhase);
+	OutState.RoundNumber = TurnNumber;
+
+	TMap<uint32, int32> moveClasses;	// FMovementCostTable::Version -> movement class in the state
+	auto makeBattleUnit = [&](AGameUnit* Unit, FBattleUnit& OutUnit)
+		{
+			OutUnit.Tile = tileGrid->GetTileIndex(Unit->GetCurrentUnitTile());
+			OutUnit.Faction = Unit->UnitFaction;
+			OutUnit.BaseMovementSpaces = Unit->BaseMovementSpaces;
+			OutUnit.BaseActions = Unit->BaseActions;
+			OutUnit.RemainingSpaces = AGameUnit::GetUnitRemainingSpaces(Unit);
+			OutUnit.RemainingActions = AGameUnit::GetUnitRemainingActions(Unit);
+			Unit->GetUnitEquippedWeaponRange(OutUnit.MinActRange, OutUnit.MaxActRange, OutUnit.bTargetsEnemies, OutUnit.bTargetsAllies);
+
+			const FMovementCostTable* costTable = Unit->GetUnitCostTable();
+			const uint32 costVersion = costTable ? costTable->Version : 0;
+			if (const int32* moveClass = moveClasses.Find(costVersion))
+			{
+				OutUnit.MoveClass = (uint8)*moveClass;
+			}
+			else
+			{
+				OutUnit.MoveClass = (uint8)OutState.AddMoveCostTable(Unit->GetUnitMoveCostTable());	// no table - every terrain blocked
+				moveClasses.Add(costVersion, OutUnit.MoveClass);
+			}
+		};
+
+	// Units captured before keep their index, even once defeated
+	TSet<AGameUnit*> knownUnits;
+	for (AGameUnit* unit : InOutUnitActors)
+	{
+		FBattleUnit battleUnit;
+		if (IsValid(unit) && unit->UnitFaction != EUnitFaction::NO_FACTION)
+		{
+			makeBattleUnit(unit, battleUnit);
+		}
+		if (OutState.AddUnit(battleUnit) == INDEX_NONE)
+		{
+			battleUnit.Tile = INDEX_NONE;	// off the grid or sharing a tile - kept as removed so the indices stay aligned
+			OutState.AddUnit(battleUnit);
+		}
+		knownUnits.Add(unit);
+	}
+
+	for (uint8 faction = EUnitFaction::PLAYER; faction < UNIT_FACTION_COUNT; faction++)
+	{
+		for (AGameUnit* unit : registry->GetFactionUnits(faction))
+		{
+			if (knownUnits.Contains(unit))
+			{
+				continue;
+			}
+
+			FBattleUnit battleUnit;
+			makeBattleUnit(unit, battleUnit);
+			if (OutState.AddUnit(battleUnit) != INDEX_NONE)
+			{
+				InOutUnitActors.Add(unit);
+			}
+		}
+	}
+}
+
+void ACombatGameMode::ApplyBattleState(const FBattleState& State, const TArray<AGameUnit*>& UnitActors)
+{
+	auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	if (!tileGrid)
+	{
+		return;
+	}
+
+	TGuardValue<bool> applyingGuard(bApplyingBattleState, true);	// restored movement and actions are not new actions
+
+	TArray<AGameUnit*> movedUnits;
+	for (int32 unitIndex = 0; unitIndex < State.Units.Num() && unitIndex < UnitActors.Num(); unitIndex++)
+	{
+		const FBattleUnit& battleUnit = State.Units[unitIndex];
+		AGameUnit* unit = UnitActors[unitIndex];
+		if (!IsValid(unit) || !battleUnit.IsInBattle())
+		{
+			continue;	// defeat is resolved by the unit's own blueprint
+		}
+
+		AGameTile* tile = tileGrid->GetTile(battleUnit.Tile);
+		if (tile && tile != unit->GetCurrentUnitTile())
+		{
+			unit->SetUnitLocAndRot(tile, unit->GetCurrentUnitDirection());
+			movedUnits.Add(unit);
+		}
+
+		if (battleUnit.Faction == State.ActiveFaction)	// other factions get their movement and actions back when their phase starts
+		{
+			unit->SetUnitRemainingSpaces(battleUnit.RemainingSpaces);
+			unit->SetUnitRemainingActions(battleUnit.RemainingActions);
+			if (!unit->ReadyToSetUnitGray())
+			{
+				unit->SetUnitGray(false);	// an undone action gives the unit its colors back
+			}
+		}
+	}
+
+	// A unit leaving its tile clears it, even if another unit was placed there first - set the moved units' tiles again once all have moved
+	for (AGameUnit* unit : movedUnits)
+	{
+		unit->GetCurrentUnitTile()->SetUnitOnTile(unit, unit->GetCurrentUnitDirection());
+	}
+}
+
+int32 ACombatGameMode::RecordBattleSnapshot()
+{
+	if (!bRecordBattleHistory || bFastForward)
+	{
+		return INDEX_NONE;
+	}
+
+	GetWorldTimerManager().ClearTimer(BattleSnapshotTimer);	// this snapshot covers any queued one, e.g. the last action before a phase change
+	bBattleSnapshotQueued = false;
+
+	// Terrain is kept once per history - a scripted terrain change starts a new one rather than being copied by every snapshot
+	auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	const uint32 terrainEpoch = tileGrid ? tileGrid->GetTerrainEpoch() : 0;
+	if (terrainEpoch != HistoryTerrainEpoch)
+	{
+		BattleHistory.Reset();
+		HistoryState.Reset();
+		HistoryUnits.Reset();
+		HistoryTerrainEpoch = terrainEpoch;
+	}
+
+	CaptureBattleState(HistoryState, HistoryUnits);
+	return BattleHistory.TakeSnapshot(HistoryState);
+}
+
+void ACombatGameMode::QueueBattleSnapshot()
+{
+	if (!bRecordBattleHistory || bFastForward || bApplyingBattleState || bBattleSnapshotQueued)
+	{
+		return;
+	}
+
+	// Next tick, so the movement and tile changes that finish the action are in the snapshot too
+	bBattleSnapshotQueued = true;
+	BattleSnapshotTimer = GetWorldTimerManager().SetTimerForNextTick(this, &ACombatGameMode::RecordQueuedBattleSnapshot);
+}
+
+void ACombatGameMode::RecordQueuedBattleSnapshot()
+{
+	RecordBattleSnapshot();
+}
+
+bool ACombatGameMode::RewindToSnapshot(int32 SnapshotIndex)
+{
+	if (IsPausedForEvent || !BattleHistory.RestoreSnapshot(SnapshotIndex, HistoryState))
+	{
+		return false;
+	}
+
+	GetWorldTimerManager().ClearTimer(BattleSnapshotTimer);	// an action queued before the rewind is undone with it
+	bBattleSnapshotQueued = false;
+
+	if (ATileControlPawn* controlPawn = GetControlPawn())
+	{
+		controlPawn->ClearUnitSelection();
+	}
+
+	// A snapshot of an earlier phase makes that phase current again. Its events already ran and are not triggered twice.
+	const ECombatPhase snapshotPhase = GetFactionPhase(HistoryState.ActiveFaction);
+	const ECombatPhase previousPhase = CurrentCombatPhase;
+	if (snapshotPhase != ECombatPhase::NO_PHASE && snapshotPhase != previousPhase)
+	{
+		PrepareUnitsOnPhaseShift(snapshotPhase, previousPhase);
+		CurrentCombatPhase = snapshotPhase;
+	}
+	TurnNumber = (uint8)HistoryState.RoundNumber;
+
+	ApplyBattleState(HistoryState, HistoryUnits);
+	BattleHistory.TruncateSnapshots(SnapshotIndex + 1);	// the undone actions are replaced by whatever happens next
+
+	if (CurrentCombatPhase != previousPhase)
 	{
-		return Cast<ATileControlPawn>(tileControlPawn);
+		OnTriggerPhase.Broadcast(CurrentCombatPhase, previousPhase, TurnNumber);
 	}
-	return nullptr;
+	return true;
 }
 
 bool ACombatGameMode::LinkToEventDataActor()
@@ -143,136 +368,128 @@ bool ACombatGameMode::LinkToEventDataActor()
 
 void ACombatGameMode::TriggerPreCombatLogic()
 {
+	if (auto* terrainInfo = GetWorld()->GetSubsystem<UTerrainInfoSubsystem>())
+	{
+		terrainInfo->BakeTerrainInfo();	// every tile has begun play and reported its terrain by now
+	}
+
 	ActivateCombatPhase(ECombatPhase::BEFORE_COMBAT);
 }
 
 void ACombatGameMode::PrepareUnitsOnPhaseShift(ECombatPhase NewPhase, ECombatPhase PreviousPhase)
 {
-	// Find all units
-	TArray<AGameUnit*> playerUnits = TArray<AGameUnit*>(), partnerUnits = TArray<AGameUnit*>(), enemyUnits = TArray<AGameUnit*>(), npcUnits = TArray<AGameUnit*>();
-	TArray<AActor*> foundUnitActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AGameUnit::StaticClass(), foundUnitActors);
+	auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>();
+	if (!registry)
+	{
+		return;
+	}
+
+	// Deactivate units from the previously active phase. The arrays are copied - blueprint handlers may spawn or destroy units.
+	const uint8 previousFaction = GetPhaseFaction(PreviousPhase);
+	if (previousFaction != EUnitFaction::NO_FACTION)
+	{
+		const TArray<AGameUnit*> previousUnits = registry->GetFactionUnits(previousFaction);
+		SetFactionActive(previousFaction, false, previousUnits);
+	}
 
-	// Sort units by allegiance
-	for (auto* actor : foundUnitActors)
+	// Activate units from the new phase
+	const uint8 newFaction = GetPhaseFaction(NewPhase);
+	if (newFaction != EUnitFaction::NO_FACTION)
 	{
-		AGameUnit* foundUnit = Cast<AGameUnit>(actor);
-		if (foundUnit)
+		const TArray<AGameUnit*> newUnits = registry->GetFactionUnits(newFaction);
+		SetFactionActive(newFaction, true, newUnits);
+
+		if (NewPhase == PLAYER_PHASE)
 		{
-			uint8 unitFaction = foundUnit->UnitFaction;
-			switch (unitFaction)
-			{
-				case (EUnitFaction::PLAYER):
-					playerUnits.Add(foundUnit);
-					break;
-				case (EUnitFaction::PARTNER):
-					partnerUnits.Add(foundUnit);
-					break;
-				case (EUnitFaction::ENEMY):
-					enemyUnits.Add(foundUnit);
-					break;
-				case (EUnitFaction::NPC):
-					npcUnits.Add(foundUnit);
-					break;
-			}
+			PrecomputeUnitReachability(newUnits);	// after activation - the search uses the reset movement and actions
 		}
 	}
+}
 
-	// Deactivate units from the previously active phase
-	switch (PreviousPhase) {
-		case (PLAYER_PHASE):
-			for (auto* unit : playerUnits)
-			{
-				unit->DeactivateUnitOnPhaseEnd();
-			}
-			break;
-		case (PARTNER_PHASE):
-			for (auto* unit : partnerUnits)
-			{
-				unit->DeactivateUnitOnPhaseEnd();
-			}
-			break;
-	
-		case (ENEMY_PHASE):
-			for (auto* unit : enemyUnits)
+void ACombatGameMode::SetFactionActive(uint8 Faction, bool bActive, const TArray<AGameUnit*>& Units)
+{
+	auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>();
+	if (!bBatchPhaseActivation || !registry)
+	{
+		for (auto* unit : Units)
+		{
+			if (bActive)
 			{
-				unit->DeactivateUnitOnPhaseEnd();
+				unit->ActivateUnitOnPhaseStart();
 			}
-			break;
-		case (NPC_PHASE):
-			for (auto* unit : npcUnits)
+			else
 			{
 				unit->DeactivateUnitOnPhaseEnd();
 			}
-			break;
+		}
+		return;
 	}
 
-	// Activate units from the previously active phase
-	switch (NewPhase) {
-		case (PLAYER_PHASE):
-			for (auto* unit : playerUnits)
-			{
-				unit->ActivateUnitOnPhaseStart();
-			}
-			break;
-		case (PARTNER_PHASE):
-			for (auto* unit : partnerUnits)
-			{
-				unit->ActivateUnitOnPhaseStart();
-			}
-			break;
+	// Game state changes now, visuals later: one faction event for blueprint and the per-unit cosmetics spread over the next frames
+	if (bActive)
+	{
+		for (auto* unit : Units)
+		{
+			unit->ResetUnitTurnState();
+		}
+	}
+	registry->QueueActivationCosmetics(Units, bActive);
+	OnFactionActivation.Broadcast(Faction, bActive, Units);
+}
 
-		case (ENEMY_PHASE):
-			for (auto* unit : enemyUnits)
-			{
-				unit->ActivateUnitOnPhaseStart();
-			}
-			break;
-		case (NPC_PHASE):
-			for (auto* unit : npcUnits)
-			{
-				unit->ActivateUnitOnPhaseStart();
-			}
-			break;
+uint8 ACombatGameMode::GetPhaseFaction(ECombatPhase Phase)
+{
+	switch (Phase)
+	{
+	case (PLAYER_PHASE):
+		return EUnitFaction::PLAYER;
+	case (PARTNER_PHASE):
+		return EUnitFaction::PARTNER;
+	case (ENEMY_PHASE):
+		return EUnitFaction::ENEMY;
+	case (NPC_PHASE):
+		return EUnitFaction::NPC;
+	default:
+		return EUnitFaction::NO_FACTION;
 	}
-	
 }
 
-void ACombatGameMode::CountUnitsByAllegiance(uint8& PlayerUnitCount, uint8& PartnerUnitCount, uint8& EnemyUnitCount, uint8& NpcUnitCount)
+ECombatPhase ACombatGameMode::GetFactionPhase(uint8 Faction)
 {
-	uint8 playerCount = 0, partnerCount = 0, enemyCount = 0, npcCount = 0;
-	TArray<AActor*> foundUnitActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AGameUnit::StaticClass(), foundUnitActors);
+	switch (Faction)
+	{
+	case (EUnitFaction::PLAYER):
+		return PLAYER_PHASE;
+	case (EUnitFaction::PARTNER):
+		return PARTNER_PHASE;
+	case (EUnitFaction::ENEMY):
+		return ENEMY_PHASE;
+	case (EUnitFaction::NPC):
+		return NPC_PHASE;
+	default:
+		return NO_PHASE;
+	}
+}
 
-	for (auto* actor : foundUnitActors)
+void ACombatGameMode::PrecomputeUnitReachability(const TArray<AGameUnit*>& Units)
+{
+	if (auto* reachability = GetWorld()->GetSubsystem<UTileReachabilitySubsystem>())
 	{
-		AGameUnit* foundUnit = Cast<AGameUnit>(actor);
-		if (foundUnit)
-		{
-			uint8 unitFaction = foundUnit->UnitFaction;
-			switch (unitFaction)
-			{
-			case (EUnitFaction::PLAYER):
-				playerCount++;
-				break;
-			case (EUnitFaction::PARTNER):
-				partnerCount++;
-				break;
-			case (EUnitFaction::ENEMY):
-				enemyCount++;
-				break;
-			case (EUnitFaction::NPC):
-				npcCount++;
-				break;
-			}
-		}
+		reachability->PrecomputeReachability(Units);
 	}
+}
 
-	PlayerUnitCount = playerCount;
-	PartnerUnitCount = partnerCount;
-	EnemyUnitCount = enemyCount;
-	NpcUnitCount = npcCount;
+void ACombatGameMode::CountUnitsByAllegiance(uint8& PlayerUnitCount, uint8& PartnerUnitCount, uint8& EnemyUnitCount, uint8& NpcUnitCount)
+{
+	PlayerUnitCount = PartnerUnitCount = EnemyUnitCount = NpcUnitCount = 0;
 
+	if (auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>())
+	{
+		PlayerUnitCount = registry->GetFactionUnitCount(EUnitFaction::PLAYER);
+		PartnerUnitCount = registry->GetFactionUnitCount(EUnitFaction::PARTNER);
+		EnemyUnitCount = registry->GetFactionUnitCount(EUnitFaction::ENEMY);
+		NpcUnitCount = registry->GetFactionUnitCount(EUnitFaction::NPC);
+	}
 }
 
 void ACombatGameMode::ActivateCombatPhase(ECombatPhase CombatPhase)
@@ -282,9 +499,19 @@ void ACombatGameMode::ActivateCombatPhase(ECombatPhase CombatPhase)
 	if (EventData)
 	{
 		ACombatEvent* foundEvent;
-		bool isEventFound = EventData->EventReady(CombatPhase, TurnNumber, foundEvent);
-		if (isEventFound)
+		while (EventData->EventReady(CombatPhase, TurnNumber, foundEvent))
 		{
+			if (bFastForward)
+			{
+				// Run the event now instead of pausing on it - its spawns and unit changes still happen, anything it waits on is cut short
+				EventData->TriggerBeginEvent(foundEvent);
+				if (!foundEvent->bEventCompleted)
+				{
+					foundEvent->TriggerEventCompleted();
+				}
+				continue;
+			}
+
 			// Pause phase logic until this event ends
 			BeginPauseForEvent(foundEvent, CombatPhase);
 			// Start event
@@ -307,6 +534,64 @@ void ACombatGameMode::ActivateCombatPhase(ECombatPhase CombatPhase)
 
 	CurrentCombatPhase = CombatPhase;
 
+	if (GetPhaseFaction(CombatPhase) != EUnitFaction::NO_FACTION)
+	{
+		RecordBattleSnapshot();	// rewind point at the start of every unit phase
+	}
+
+	if (bFastForward)
+	{
+		if (GetPhaseFaction(CombatPhase) != EUnitFaction::NO_FACTION)
+		{
+			SimPhaseCount++;
+			if (CombatPhase <= LastUnitPhase)
+			{
+				SimRoundCount++;
+			}
+			LastUnitPhase = CombatPhase;
+		}
+
+		switch (CombatPhase)
+		{
+			case(BEFORE_COMBAT):
+			case(TRANSITION_PLAYER_PHASE):
+			case(TRANSITION_PARTNER_PHASE):
+			case(TRANSITION_ENEMY_PHASE):
+			case(TRANSITION_NPC_PHASE):
+				// nothing to wait for - next tick rather than now, so handlers of this phase run first
+				GetWorldTimerManager().SetTimerForNextTick(this, &ACombatGameMode::BeginNextCombatPhase);
+				break;
+			case(PLAYER_PHASE):
+				DriveFastForwardPlayerPhase();	// no one is there to give input
+				break;
+			case(AFTER_COMBAT):
+			case(GAME_OVER):
+				ReportSimulationStats();
+				break;
+		}
+	}
+}
+
+void ACombatGameMode::DriveFastForwardPlayerPhase_Implementation()
+{
+	GetWorldTimerManager().SetTimerForNextTick(this, &ACombatGameMode::BeginNextCombatPhase);	// the player units hold their ground
+}
+
+void ACombatGameMode::ReportSimulationStats()
+{
+	const double elapsedSeconds = FMath::Max(FPlatformTime::Seconds() - SimStartTime, 0.001);
+
+	uint8 playerUnitCount, partnerUnitCount, enemyUnitCount, npcUnitCount;
+	CountUnitsByAllegiance(playerUnitCount, partnerUnitCount, enemyUnitCount, npcUnitCount);
+
+	UE_LOG(LogTemp, Display, TEXT("Fast-forward battle ended in %s after %d rounds / %d phases in %.2fs (%.1f rounds/s, %.1f phases/s). Units left - player: %d, partner: %d, enemy: %d, npc: %d"),
+		CurrentCombatPhase == GAME_OVER ? TEXT("GAME_OVER") : TEXT("AFTER_COMBAT"), SimRoundCount + 1, SimPhaseCount, elapsedSeconds,
+		(SimRoundCount + 1) / elapsedSeconds, SimPhaseCount / elapsedSeconds, playerUnitCount, partnerUnitCount, enemyUnitCount, npcUnitCount);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("TRPGExitAfterBattle")))
+	{
+		FPlatformMisc::RequestExit(false);	// lets a script run the next battle in a fresh process
+	}
 }
 
 
@@ -3,6 +3,8 @@
 
 #include "GameTile.h"
 #include "GameUnit.h"
+#include "TileGridSubsystem.h"
+#include "TerrainInfoSubsystem.h"
 
 
 // Sets default values
@@ -33,7 +35,10 @@ void AGameTile::BeginPlay()
 {
 	Super::BeginPlay();
 	
-	TerrainTypeByte = GetTerrainTypeByte();
+	if (TerrainTypeByte == 255)
+	{
+		SetTerrainType(GetTerrainTypeByte());	// not loaded from a baked tile graph - ask the blueprint
+	}
 }
 
 // Called every frame
@@ -127,6 +132,56 @@ void AGameTile::TriggerTileInteractable(bool Toggle)
 	}
 }
 
+uint8 AGameTile::GetOverlayFlags() const
+{
+	return (IsNavigable ? OVERLAY_NAVIGABLE : 0) | (IsAttackable ? OVERLAY_ATTACKABLE : 0) | (IsInteractable ? OVERLAY_INTERACTABLE : 0);
+}
+
+void AGameTile::SetOverlayFlags(uint8 Flags)
+{
+	IsNavigable		= (Flags & OVERLAY_NAVIGABLE) != 0;
+	IsAttackable	= (Flags & OVERLAY_ATTACKABLE) != 0;
+	IsInteractable	= (Flags & OVERLAY_INTERACTABLE) != 0;
+}
+
+void AGameTile::BroadcastOverlayChange(uint8 OldFlags, uint8 NewFlags)
+{
+	const uint8 changedFlags = OldFlags ^ NewFlags;
+	if (changedFlags & OVERLAY_NAVIGABLE)
+	{
+		if (NewFlags & OVERLAY_NAVIGABLE)
+		{
+			OnTileSetNavigable.Broadcast();
+		}
+		else
+		{
+			OnTileUnsetNavigable.Broadcast();
+		}
+	}
+	if (changedFlags & OVERLAY_ATTACKABLE)
+	{
+		if (NewFlags & OVERLAY_ATTACKABLE)
+		{
+			OnTileSetAttackable.Broadcast();
+		}
+		else
+		{
+			OnTileUnsetAttackable.Broadcast();
+		}
+	}
+	if (changedFlags & OVERLAY_INTERACTABLE)
+	{
+		if (NewFlags & OVERLAY_INTERACTABLE)
+		{
+			OnTileSetInteractable.Broadcast();
+		}
+		else
+		{
+			OnTileUnsetInteractable.Broadcast();
+		}
+	}
+}
+
 void AGameTile::TriggerTilePathing(bool Toggle, ECardinalDirections PastTileDirection, ECardinalDirections NextTileDirection)
 {
 	if (Toggle)
@@ -141,18 +196,17 @@ void AGameTile::TriggerTilePathing(bool Toggle, ECardinalDirections PastTileDire
 
 void AGameTile::SetUnitOnTile(AGameUnit* Unit, ECardinalDirections Direction)
 {
-	if (!Unit)
+	CurrentUnit = Unit;
+
+	if (auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>())
 	{
-		CurrentUnit = nullptr;
-		return;
+		tileGrid->SetTileOccupant(TileIndex, Unit);
 	}
-
-	CurrentUnit = Unit;
 }
 
 AGameTile* AGameTile::GetNorthTile()
 {
-	if (!NorthTile)
+	if (!NorthTile && !bNeighborsLinked)
 	{
 		// double check there is no north tile
 		FVector actorLoc = GetActorLocation();
@@ -191,7 +245,7 @@ AGameTile* AGameTile::GetNorthTile()
 
 AGameTile* AGameTile::GetWestTile()
 {
-	if (!WestTile)
+	if (!WestTile && !bNeighborsLinked)
 	{
 		// double check there is no north tile
 		FVector actorLoc = GetActorLocation();
@@ -230,7 +284,7 @@ AGameTile* AGameTile::GetWestTile()
 
 AGameTile* AGameTile::GetSouthTile()
 {
-	if (!SouthTile)
+	if (!SouthTile && !bNeighborsLinked)
 	{
 		// double check there is no north tile
 		FVector actorLoc = GetActorLocation();
@@ -269,7 +323,7 @@ AGameTile* AGameTile::GetSouthTile()
 
 AGameTile* AGameTile::GetEastTile()
 {
-	if (!EastTile)
+	if (!EastTile && !bNeighborsLinked)
 	{
 		// double check there is no north tile
 		FVector actorLoc = GetActorLocation();
@@ -319,6 +373,21 @@ bool AGameTile::GetTilesAreAdjacent(AGameTile* A, AGameTile* B, bool& bIsNorthTi
 		return false;
 	}
 
+	auto* tileGrid = A->GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	const int32 indexA = tileGrid ? tileGrid->GetTileIndex(A) : INDEX_NONE;
+	const int32 indexB = tileGrid ? tileGrid->GetTileIndex(B) : INDEX_NONE;
+	if (indexA != INDEX_NONE && indexB != INDEX_NONE)
+	{
+		// Both tiles are indexed - compare neighbor indices without calling the tile getters
+		const FTileGridData& gridData = tileGrid->GetGridData();
+		bIsNorthTile = gridData.GetNeighbor(indexA, NEIGHBOR_NORTH) == indexB;
+		bIsEastTile = gridData.GetNeighbor(indexA, NEIGHBOR_EAST) == indexB;
+		bIsSouthTile = gridData.GetNeighbor(indexA, NEIGHBOR_SOUTH) == indexB;
+		bIsWestTile = gridData.GetNeighbor(indexA, NEIGHBOR_WEST) == indexB;
+
+		return bIsNorthTile || bIsEastTile || bIsSouthTile || bIsWestTile;
+	}
+
 	bIsNorthTile = A->GetNorthTile() == B;
 	bIsEastTile = A->GetEastTile() == B;
 	bIsSouthTile = A->GetSouthTile() == B;
@@ -329,127 +398,36 @@ bool AGameTile::GetTilesAreAdjacent(AGameTile* A, AGameTile* B, bool& bIsNorthTi
 
 void AGameTile::InitializeLinkToNeighbors()
 {
-	FVector actorLoc = GetActorLocation();
-	FVector northTraceLoc1, northTraceLoc2, westTraceLoc1, westTraceLoc2, 
-		eastTraceLoc1, eastTraceLoc2, southTraceLoc1, southTraceLoc2;
-
-	northTraceLoc1 = FVector(actorLoc.X + AdjacentTileDistance, actorLoc.Y, actorLoc.Z - (AdjacentTileVerticalRange / 2));
-	northTraceLoc2 = FVector(actorLoc.X + AdjacentTileDistance, actorLoc.Y, actorLoc.Z + (AdjacentTileVerticalRange / 2));
-
-	westTraceLoc1 = FVector(actorLoc.X, actorLoc.Y - AdjacentTileDistance, actorLoc.Z - (AdjacentTileVerticalRange / 2));
-	westTraceLoc2 = FVector(actorLoc.X, actorLoc.Y - AdjacentTileDistance, actorLoc.Z + (AdjacentTileVerticalRange / 2));
-
-	eastTraceLoc1 = FVector(actorLoc.X, actorLoc.Y + AdjacentTileDistance, actorLoc.Z - (AdjacentTileVerticalRange / 2));
-	eastTraceLoc2 = FVector(actorLoc.X, actorLoc.Y + AdjacentTileDistance, actorLoc.Z + (AdjacentTileVerticalRange / 2));
-
-	southTraceLoc1 = FVector(actorLoc.X - AdjacentTileDistance, actorLoc.Y, actorLoc.Z - (AdjacentTileVerticalRange / 2));
-	southTraceLoc2 = FVector(actorLoc.X - AdjacentTileDistance, actorLoc.Y, actorLoc.Z + (AdjacentTileVerticalRange / 2));
-
-	FHitResult northTraceResult, westTraceResult, eastTraceResult, southTraceResult;
-
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this); // Optional, to ignore the actor making the trace
-
-	FCollisionObjectQueryParams ObjectQueryParams;
-	ObjectQueryParams.AddObjectTypesToQuery(ECC_WorldStatic);  // Only trace against static objects
-
-
-	// Execute the north line trace
-	bool bNorthHit = GetWorld()->LineTraceSingleByObjectType(
-		northTraceResult,
-		northTraceLoc1,
-		northTraceLoc2,
-		ObjectQueryParams,
-		CollisionParams
-	);
-
-	// Execute the west line trace
-	bool bWestHit = GetWorld()->LineTraceSingleByObjectType(
-		westTraceResult,
-		westTraceLoc1,
-		westTraceLoc2,
-		ObjectQueryParams,
-		CollisionParams
-	);
-
-	// Execute the east line trace
-	bool bEastHit = GetWorld()->LineTraceSingleByObjectType(
-		eastTraceResult,
-		eastTraceLoc1,
-		eastTraceLoc2,
-		ObjectQueryParams,
-		CollisionParams
-	);
-
-	// Execute the east line trace
-	bool bSouthHit = GetWorld()->LineTraceSingleByObjectType(
-		southTraceResult,
-		southTraceLoc1,
-		southTraceLoc2,
-		ObjectQueryParams,
-		CollisionParams
-	);
-
-	// If the hit actor is a tile, then save it as an adjacent tile
-	
-	bool bFoundNorth = false, bFoundSouth = false, bFoundEast = false, bFoundWest = false;
-
-	if (bNorthHit)
-	{
-		auto* northHitTraceOwner = northTraceResult.GetActor();
-		if (auto* northTile = Cast<AGameTile>(northHitTraceOwner))
-		{
-			NorthTile = northTile;
-			bFoundNorth = true;
-		}
-	}
-	if (!bFoundNorth)
-	{
-		NorthTile = nullptr;
-	}
+	// Links the whole map in one pass the first time any tile saves. The remaining tiles reuse the result.
+	UTileGridSubsystem::LinkWorldTileNeighbors(GetWorld());
+}
 
+void AGameTile::SetTerrainType(uint8 NewTerrainTypeByte)
+{
+	TerrainTypeByte = NewTerrainTypeByte;
 
-	if (bWestHit)
+	if (auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>())
 	{
-		auto* westHitTraceOwner = westTraceResult.GetActor();
-		if (auto* westTile = Cast<AGameTile>(westHitTraceOwner))
-		{
-			WestTile = westTile;
-			bFoundWest = true;
-		}
-	}
-	if (!bFoundWest)
-	{
-		WestTile = nullptr;
+		tileGrid->SetTileTerrainType(TileIndex, TerrainTypeByte);
 	}
+}
 
-	if (bEastHit)
-	{
-		auto* eastHitTraceOwner = eastTraceResult.GetActor();
-		if (auto* eastTile = Cast<AGameTile>(eastHitTraceOwner))
-		{
-			EastTile = eastTile;
-			bFoundEast = true;
-		}
-	}
-	if (!bFoundEast)
+FTerrainInfo AGameTile::GetCachedTerrainInfoForHud()
+{
+	if (auto* terrainInfo = GetWorld()->GetSubsystem<UTerrainInfoSubsystem>())
 	{
-		EastTile = nullptr;
+		return terrainInfo->GetTerrainInfoForHud(this);
 	}
+	return GetTerrainInfoForHud();
+}
 
-	if (bSouthHit)
-	{
-		auto* southHitTraceOwner = southTraceResult.GetActor();
-		if (auto* southTile = Cast<AGameTile>(southHitTraceOwner))
-		{
-			SouthTile = southTile;
-			bFoundSouth = true;
-		}
-	}
-	if (!bFoundSouth)
+FTerrainInfo AGameTile::GetCachedTerrainInfoForUnit(const uint8 UnitMovementTypeInBytes)
+{
+	if (auto* terrainInfo = GetWorld()->GetSubsystem<UTerrainInfoSubsystem>())
 	{
-		SouthTile = nullptr;
+		return terrainInfo->GetTerrainInfoForUnit(this, UnitMovementTypeInBytes);
 	}
+	return GetTerrainInfoForUnit(UnitMovementTypeInBytes);
 }
 
 const uint8 AGameTile::GetTerrainTypeAsByte(AGameTile* Tile)
@@ -3,6 +3,14 @@
 #include "GameUnit.h"
 #include "GameTile.h"
 #include "UnitMovementData.h"
+#include "TileGridSubsystem.h"
+#include "TileBitset.h"
+#include "TileInstanceManager.h"
+#include "UnitRegistrySubsystem.h"
+#include "BattleState.h"
+#include "CombatGameMode.h"
+
+static_assert(EUnitFaction::NPC == BATTLE_FACTION_NPC && UNIT_FACTION_COUNT == BATTLE_FACTION_COUNT, "EUnitFaction and EBattleFaction must match");
 
 // Sets default values
 AGameUnit::AGameUnit()
@@ -20,6 +28,23 @@ void AGameUnit::BeginPlay()
 	InitializeSetUnitOnInitialTile();
 
 	InitializeUnitMovementData();
+
+	InitializeBaseMovementSpaces();
+
+	if (auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>())
+	{
+		registry->RegisterUnit(this);
+	}
+}
+
+void AGameUnit::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>())
+	{
+		registry->UnregisterUnit(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -31,16 +56,50 @@ void AGameUnit::Tick(float DeltaTime)
 
 void AGameUnit::ActivateUnitOnPhaseStart()
 {
-	OnUnitActivation.Broadcast(true);
+	ApplyActivationCosmetics(true);
 
-	ResetUnitMovementAndActions();
+	ResetUnitTurnState();
 }
 
 void AGameUnit::DeactivateUnitOnPhaseEnd()
 {
-	OnUnitActivation.Broadcast(false);
+	ApplyActivationCosmetics(false);
+}
+
+void AGameUnit::ResetUnitTurnState()
+{
+	if (bResetTurnNatively)
+	{
+		RemainingMovementSpaces = BaseMovementSpaces;
+		RemainingActions = BaseActions;
+	}
+	else
+	{
+		ResetUnitMovementAndActions();
+		BaseMovementSpaces = RemainingMovementSpaces;	// follow the Blueprint stat, e.g. after a level up
+	}
+}
+
+void AGameUnit::ApplyActivationCosmetics(bool bActivated)
+{
+	OnUnitActivation.Broadcast(bActivated);
 
-	SetUnitGray(false);	// Remove grayscale when it's not the unit's turn
+	if (!bActivated)
+	{
+		SetUnitGray(false);	// Remove grayscale when it's not the unit's turn
+	}
+}
+
+void AGameUnit::SetUnitFaction(uint8 NewFaction)
+{
+	if (auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>())
+	{
+		registry->SetUnitFaction(this, NewFaction);
+	}
+	else
+	{
+		UnitFaction = NewFaction;
+	}
 }
 
 void AGameUnit::SetUnitLocAndRot(AGameTile* TargetTile, ECardinalDirections TargetDirection)
@@ -134,12 +193,21 @@ uint8 AGameUnit::GetUnitRemainingSpaces(AGameUnit*& Unit)
 
 void AGameUnit::SetUnitRemainingActions(uint8 NewRemainingActions)
 {
+	const bool bActionSpent = NewRemainingActions < RemainingActions;
 	RemainingActions = NewRemainingActions;
 
 	if (ReadyToSetUnitGray())
 	{
 		SetUnitGray(true);
 	}
+
+	if (bActionSpent)
+	{
+		if (ACombatGameMode* combatGameMode = Cast<ACombatGameMode>(UGameplayStatics::GetGameMode(GetWorld())))
+		{
+			combatGameMode->QueueBattleSnapshot();	// rewind point after every action, whichever faction or AI took it
+		}
+	}
 }
 
 uint8 AGameUnit::GetUnitRemainingActions(AGameUnit*& Unit)
@@ -147,43 +215,115 @@ uint8 AGameUnit::GetUnitRemainingActions(AGameUnit*& Unit)
 	return Unit->RemainingActions;
 }
 
-uint8 AGameUnit::GetUnitMovementForTile(uint8 TerrainType)
+uint8 AGameUnit::GetUnitMovementForTile(uint8 TerrainType) const
+{
+	return MovementDataComponent ? MovementDataComponent->GetMoveCostInfo(TerrainType) : 255;
+}
+
+TConstArrayView<uint8> AGameUnit::GetUnitMoveCostTable() const
 {
 	if (MovementDataComponent)
 	{
-		return MovementDataComponent->GetMoveCostInfo(TerrainType);
+		return MovementDataComponent->GetMoveCostTable();
+	}
+	return TConstArrayView<uint8>();
+}
+
+const FMovementCostTable* AGameUnit::GetUnitCostTable() const
+{
+	return MovementDataComponent ? &MovementDataComponent->GetCostTable() : nullptr;
+}
+
+void AGameUnit::MakeReachabilityQuery(UTileGridSubsystem& TileGrid, int32 StartTile, int32 MoveBudget, bool bWithWeapon, FTileReachabilityQuery& OutQuery)
+{
+	OutQuery = FTileReachabilityQuery();
+	OutQuery.StartTile = StartTile;
+	OutQuery.MoveBudget = MoveBudget;
+	OutQuery.MoveCosts = GetUnitMoveCostTable();
+	if (const FMovementCostTable* costTable = GetUnitCostTable())
+	{
+		OutQuery.SetTileCosts(TileGrid.GetMoveCostGrid(*costTable));
+	}
+	OutQuery.HostileFactions = GetHostileFactionMask(UnitFaction);
+	OutQuery.AlliedFactions = GetAlliedFactionMask(UnitFaction);
+
+	if (bWithWeapon)
+	{
+		GetUnitEquippedWeaponRange(OutQuery.MinActRange, OutQuery.MaxActRange, OutQuery.bTargetsEnemies, OutQuery.bTargetsAllies);
 	}
-	return 255;
+}
+
+void AGameUnit::MakeSelectionQuery(UTileGridSubsystem& TileGrid, int32 StartTile, FTileReachabilityQuery& OutQuery)
+{
+	AGameUnit* unit = this;
+	const bool hasAction = GetUnitRemainingActions(unit) > 0;	// get weapon data only if an action is available
+	MakeReachabilityQuery(TileGrid, StartTile, GetUnitRemainingSpaces(unit), hasAction, OutQuery);
+}
+
+uint32 AGameUnit::GetHostileFactionMask(uint8 Faction)
+{
+	return FBattleState::GetHostileFactionMask(Faction);
+}
+
+uint32 AGameUnit::GetAlliedFactionMask(uint8 Faction)
+{
+	return FBattleState::GetAlliedFactionMask(Faction);
 }
 
 void AGameUnit::GetUnitsInRange(const uint8 MinRange, const uint8 MaxRange, const TArray<TEnumAsByte<EUnitFaction>> TargetFactions, AGameTile* CurrentTile, TArray<AGameTile*> SearchedTiles, TArray<AGameUnit*>& FoundUnits, const uint8 SearchDepth )
 {
-	if (SearchDepth > MaxRange || !CurrentTile || SearchedTiles.Contains(CurrentTile))
+	if (SearchDepth > MaxRange || !CurrentTile)
 	{
 		// out of range
 		return;
 	}
 
-	if (SearchDepth >= MinRange && SearchDepth <= MaxRange)
+	auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	const int32 startIndex = tileGrid ? tileGrid->GetTileIndex(CurrentTile) : INDEX_NONE;
+	if (startIndex == INDEX_NONE)
+	{
+		return;	// tile is not part of the indexed grid
+	}
+
+	uint32 factionMask = 0;
+	for (EUnitFaction faction : TargetFactions)
+	{
+		factionMask |= 1u << faction;
+	}
+
+	// Ring query on the faction cell masks - SearchDepth is the distance already covered to reach CurrentTile
+	TArray<AGameUnit*> unitsInRange;
+	tileGrid->GetUnitsInRange(startIndex, MinRange - SearchDepth, MaxRange - SearchDepth, factionMask, unitsInRange);
+	if (unitsInRange.IsEmpty())
+	{
+		return;
+	}
+
+	FTileBitset searchedTiles(tileGrid->GetTileCount());		// previously searched tiles are skipped
+	for (const AGameTile* tile : SearchedTiles)
 	{
-		AGameUnit* checkUnit;
-		if (CurrentTile->GetUnitOnTile(checkUnit))
+		const int32 tileIndex = tileGrid->GetTileIndex(tile);
+		if (tileIndex != INDEX_NONE)
 		{
-			if (TargetFactions.Contains(checkUnit->UnitFaction))
-			{
-				// Unit has the correct faction, add to found unit array
-				FoundUnits.AddUnique(checkUnit);
-			}
+			searchedTiles.Add(tileIndex);
 		}
 	}
-	SearchedTiles.Add(CurrentTile);
 
-	// Check north/south/east/west tiles
-	GetUnitsInRange(MinRange, MaxRange, TargetFactions, CurrentTile->GetNorthTile(), SearchedTiles, FoundUnits, SearchDepth + 1);
-	GetUnitsInRange(MinRange, MaxRange, TargetFactions, CurrentTile->GetSouthTile(), SearchedTiles, FoundUnits, SearchDepth + 1);
-	GetUnitsInRange(MinRange, MaxRange, TargetFactions, CurrentTile->GetEastTile(), SearchedTiles, FoundUnits, SearchDepth + 1);
-	GetUnitsInRange(MinRange, MaxRange, TargetFactions, CurrentTile->GetWestTile(), SearchedTiles, FoundUnits, SearchDepth + 1);
+	TSet<AGameUnit*> foundSet(FoundUnits);		// units already found by the caller
+	for (AGameUnit* unit : unitsInRange)
+	{
+		if (searchedTiles.Contains(tileGrid->GetTileIndex(unit->GetCurrentUnitTile())))
+		{
+			continue;
+		}
 
+		bool bAlreadyFound = false;
+		foundSet.Add(unit, &bAlreadyFound);
+		if (!bAlreadyFound)
+		{
+			FoundUnits.Add(unit);
+		}
+	}
 }
 
 bool AGameUnit::ReadyToSetUnitGray()
@@ -237,7 +377,13 @@ void AGameUnit::InitializeSetUnitOnInitialTile()
 		for (auto traceResult : traceResults)
 		{
 			auto* hitTraceOwner = traceResult.Component->GetOwner();
-			if (auto* tile = Cast<AGameTile>(hitTraceOwner))
+			auto* tile = Cast<AGameTile>(hitTraceOwner);
+			if (auto* instanceManager = Cast<ATileInstanceManager>(hitTraceOwner))
+			{
+				tile = instanceManager->GetTileFacade(traceResult.Item);	// instanced tiles - the hit instance is the tile index
+			}
+
+			if (tile)
 			{
 				float yaw = GetActorRotation().Yaw;
 
@@ -264,6 +410,22 @@ void AGameUnit::InitializeSetUnitOnInitialTile()
 	}
 }
 
+void AGameUnit::InitializeBaseMovementSpaces()
+{
+	if (BaseMovementSpaces > 0 || bResetTurnNatively)
+	{
+		return;
+	}
+
+	// The movement stat lives in Blueprint - run the turn reset once to read it, then put the turn state back
+	const uint8 remainingSpaces = RemainingMovementSpaces;
+	const uint8 remainingActions = RemainingActions;
+	ResetUnitMovementAndActions();
+	BaseMovementSpaces = RemainingMovementSpaces;
+	RemainingMovementSpaces = remainingSpaces;
+	RemainingActions = remainingActions;
+}
+
 void AGameUnit::InitializeUnitMovementData()
 {
 	auto* component = GetComponentByClass<UUnitMovementData>();
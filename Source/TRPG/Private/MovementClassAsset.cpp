@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementClassAsset.h"
+
+static volatile int32 GMovementCostTableVersion = 0;
+
+FMovementCostTable::FMovementCostTable()
+{
+	FMemory::Memset(MoveCosts, 255, sizeof(MoveCosts));
+	FMemory::Memzero(Bonuses, sizeof(Bonuses));
+	Version = (uint32)FPlatformAtomics::InterlockedIncrement(&GMovementCostTableVersion);
+	MoveCostHash = FCrc::MemCrc32(MoveCosts, sizeof(MoveCosts));
+}
+
+void FMovementCostTable::Compile(const TMap<uint8, FTerrainInfo>& TerrainData)
+{
+	FMemory::Memset(MoveCosts, 255, sizeof(MoveCosts));	// missing data from map
+	FMemory::Memzero(Bonuses, sizeof(Bonuses));
+	Version = (uint32)FPlatformAtomics::InterlockedIncrement(&GMovementCostTableVersion);
+
+	for (const TPair<uint8, FTerrainInfo>& terrain : TerrainData)
+	{
+		MoveCosts[terrain.Key] = terrain.Value.MoveCost;
+
+		FPackedTerrainBonus& bonus = Bonuses[terrain.Key];
+		bonus.DefStatBoost	= terrain.Value.DefStatBoost;
+		bonus.ResStatBoost	= terrain.Value.ResStatBoost;
+		bonus.AvoStatBoost	= terrain.Value.AvoStatBoost;
+		bonus.HealFlat		= terrain.Value.HealFlat;
+		bonus.HealPercent	= terrain.Value.HealPercent;
+	}
+	MoveCostHash = FCrc::MemCrc32(MoveCosts, sizeof(MoveCosts));
+}
+
+FTerrainInfo FMovementCostTable::GetTerrainInfo(uint8 TerrainType) const
+{
+	const FPackedTerrainBonus& bonus = Bonuses[TerrainType];
+
+	FTerrainInfo info;
+	info.MoveCost		= MoveCosts[TerrainType];
+	info.DefStatBoost	= bonus.DefStatBoost;
+	info.ResStatBoost	= bonus.ResStatBoost;
+	info.AvoStatBoost	= bonus.AvoStatBoost;
+	info.HealFlat		= bonus.HealFlat;
+	info.HealPercent	= bonus.HealPercent;
+	return info;
+}
+
+void UMovementClassAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	CompileCostTable();
+}
+
+#if WITH_EDITOR
+void UMovementClassAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompileCostTable();
+}
+#endif
+
+FTerrainInfo UMovementClassAsset::GetTerrainInfo(uint8 TerrainType) const
+{
+	if (const FTerrainInfo* info = TerrainData.Find(TerrainType))
+	{
+		return *info;
+	}
+	return FTerrainInfo();	// missing data from map
+}
+
+void UMovementClassAsset::CompileCostTable()
+{
+	CostTable.Compile(TerrainData);
+}
@@ -2,6 +2,8 @@
 
 
 #include "PlayerPathControl.h"
+#include "TileGridSubsystem.h"
+#include "MovementClassAsset.h"
 
 // Sets default values for this component's properties
 UPlayerPathControl::UPlayerPathControl()
@@ -19,6 +21,8 @@ void UPlayerPathControl::BeginPlay()
 {
 	Super::BeginPlay();
 
+	TileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();
+
 	BindToTileControlPawn();
 	
 }
@@ -82,11 +86,9 @@ void UPlayerPathControl::TileUnitSelected(AGameTile* Tile, AGameUnit* Unit)
 void UPlayerPathControl::TileUnitUnselected()
 {
 	MaxMovementDist = 0;
-	for (auto* tile : CurrentPath)
-	{
-		tile->TriggerTilePathing(false, ECardinalDirections::NONE, ECardinalDirections::NONE);
-	}
+	ClearPathDisplays();
 	CurrentPath.Empty();
+	ResetCurrentPathTiles();
 	StartingTile = nullptr;
 	SelectedUnit = nullptr;
 	IsPathing = false;
@@ -101,6 +103,7 @@ void UPlayerPathControl::SetIsPathingUnit(const bool IsPathingUnit, AGameTile* S
 	CurrentPath.Empty();
 	if (IsPathingUnit)
 		CurrentPath.Add(StartingTile);
+	ResetCurrentPathTiles();
 }
 
 void UPlayerPathControl::TileHovered(AGameTile* Tile)
@@ -116,279 +119,211 @@ void UPlayerPathControl::TileHovered(AGameTile* Tile)
 		return; // the path should not be empty when pathing
 	}
 
-	const TArray<AGameTile*> prevPath = CurrentPath;
 	TArray<AGameTile*> newPath;
 	bool successFindingPath;
 
-	if (CurrentPath.Contains(Tile))
+	if (IsTileOnCurrentPath(Tile))
 	{
 		// the current path already has this tile - trim the path so this is the end of the route
-		bool tileRemovalComplete = false;
-		newPath = prevPath;
-		while (newPath.Top() != Tile)
+		while (CurrentPath.Top() != Tile)
 		{
-			newPath.Pop();
+			CurrentPath.Pop();
 		}
-		CurrentPath = newPath;
-		UpdateTileDisplaysForNewPath(CurrentPath, prevPath);
+		UpdateTileDisplaysForNewPath(CurrentPath);
 		return;
 	}
 
-	if (CurrentPath.Num() <= MaxMovementDist)
+	bool isNorthTile, isSouthTile, isEastTile, isWestTile;
+	if (AGameTile::GetTilesAreAdjacent(lastPathTile, Tile, isNorthTile, isEastTile, isSouthTile, isWestTile) && GetPathMoveCost(CurrentPath) + GetTileMoveCost(Tile) <= MaxMovementDist)
 	{
-		// allowed to immediately allocate new tiles still
-		
-		bool isNorthTile, isSouthTile, isEastTile, isWestTile;
-		if (AGameTile::GetTilesAreAdjacent(lastPathTile, Tile, isNorthTile, isEastTile, isSouthTile, isWestTile))
-		{
-			// The new tile is adjacent to the last tile - easy append
-			CurrentPath.Add(Tile);
-			UpdateTileDisplaysForNewPath(CurrentPath, prevPath);
-			return;
-		}
-		
-		// the new tile is not adjacent to the last tile
-		// check if a new path can be auto-generated starting from the last existing tile to get to reach this new tile
-		successFindingPath = CalculateNewPathToReachTile(CurrentPath, Tile, newPath);
-		if (successFindingPath)
-		{
-			CurrentPath = newPath;
-			UpdateTileDisplaysForNewPath(CurrentPath, prevPath);
-			return;
-		}
+		// The new tile is adjacent to the last tile - easy append
+		CurrentPath.Add(Tile);
+		UpdateTileDisplaysForNewPath(CurrentPath);
+		return;
 	}
 
-	// if the path cannot just add tiles to reach the destination, backtrack one tile at a tile and keep checking if the new path can be auto-generated
-	// This should eventually work. Worst case involves calculating from the starting tile.
-	TArray<AGameTile*> trimmedPath = prevPath;
-	while (trimmedPath.Num() > 0)
+	// the new tile is not adjacent to the last tile or is too far to append
+	// one search picks how much of the current path to keep and the cheapest route from there to the new tile
+	successFindingPath = CalculateNewPathToReachTile(CurrentPath, Tile, newPath);
+	if (successFindingPath)
 	{
-		trimmedPath.Pop();
-		successFindingPath = CalculateNewPathToReachTile(trimmedPath, Tile, newPath);
-		if (successFindingPath)
-		{
-			CurrentPath = newPath;
-			UpdateTileDisplaysForNewPath(CurrentPath, prevPath);
-			return;
-		}
+		CurrentPath = newPath;
+		UpdateTileDisplaysForNewPath(CurrentPath);
+		return;
 	}
 
 	// couldn't find a new path - do nothing and leave the current path as-is
 	return;
 }
 
-void UPlayerPathControl::UpdateTileDisplaysForNewPath(const TArray<AGameTile*> NewPath, const TArray<AGameTile*> PrevPath)
+void UPlayerPathControl::UpdateTileDisplaysForNewPath(const TArray<AGameTile*>& NewPath)
 {
-	for (auto* tile : PrevPath)
+	if (!TileGrid)
 	{
-		if (!NewPath.Contains(tile))
-		{
-			tile->TriggerTilePathing(false, ECardinalDirections::NONE, ECardinalDirections::NONE);
-		}
+		return;
 	}
-	for (int i = 0; i < NewPath.Num(); i++)
-	{
-		// NewPath is ignored and we need to report origin and target directions for each tile
-		ECardinalDirections origin, target;
-		AGameTile* currentTile = NewPath[i];
 
-		AGameTile* northTile, *southTile, *eastTile, *westTile;
-		northTile = currentTile->GetNorthTile();
-		southTile = currentTile->GetSouthTile();
-		eastTile = currentTile->GetEastTile();
-		westTile = currentTile->GetWestTile();
+	const FTileGridData& gridData = TileGrid->GetGridData();
 
-		if (i == 0)
+	// Arrow state of every tile on the new path. Each step is looked up once - it is the target of one tile and the origin of the next.
+	TMap<int32, uint8> newPathArrows;
+	newPathArrows.Reserve(NewPath.Num());
+	FTileBitset newPathTiles(TileGrid->GetTileCount());
+
+	ECardinalDirections origin = ECardinalDirections::NONE;	// the first tile has no origin
+	for (int i = 0; i < NewPath.Num(); i++)
+	{
+		const int32 tileIndex = TileGrid->GetTileIndex(NewPath[i]);
+		ECardinalDirections target = ECardinalDirections::NONE;	// the last tile has no target
+		ECardinalDirections nextOrigin = ECardinalDirections::NONE;
+		ETileNeighbor stepDirection;
+		if (i + 1 < NewPath.Num() && gridData.GetAreAdjacent(tileIndex, TileGrid->GetTileIndex(NewPath[i + 1]), stepDirection))
 		{
-			// this is the first tile
-			origin = ECardinalDirections::NONE;
+			target = UTileGridSubsystem::NeighborToCardinal(stepDirection);
+			nextOrigin = UTileGridSubsystem::NeighborToCardinal(FTileGridData::GetOppositeNeighbor(stepDirection));	// the next tile's path came from the opposite side
 		}
-		else
+
+		if (tileIndex != INDEX_NONE)
 		{
-			// there is a tile before this one
-			AGameTile* prevTile = NewPath[i - 1];
-			if (southTile == prevTile)
-			{
-				// the path started south-to-north
-				origin = ECardinalDirections::DOWN_DIR;
-			}
-			else if (eastTile == prevTile)
-			{
-				// the path started east-to-west
-				origin = ECardinalDirections::RIGHT_DIR;
-			}
-			else if (westTile == prevTile)
-			{
-				// the path started west-to-east
-				origin = ECardinalDirections::LEFT_DIR;
-			}
-			else if (northTile == prevTile)
-			{
-				// the path started north-to-south
-				origin = ECardinalDirections::UP_DIR;
-			}
-			else
-			{
-				// no idea where the path came from, tile-linking error maybe
-				origin = ECardinalDirections::NONE;
-			}
+			newPathArrows.Add(tileIndex, MakePathArrowState(origin, target));
+			newPathTiles.Add(tileIndex);
 		}
-		if (NewPath.Num() - 1 == i) 
+		origin = nextOrigin;
+	}
+
+	// Only signal tiles whose arrows changed
+	for (const TPair<int32, uint8>& displayedArrow : DisplayedPathArrows)
+	{
+		AGameTile* tile = !newPathTiles.Contains(displayedArrow.Key) ? TileGrid->GetTile(displayedArrow.Key) : nullptr;
+		if (tile)
 		{
-			// this is the last tile
-			target = ECardinalDirections::NONE;
+			tile->TriggerTilePathing(false, ECardinalDirections::NONE, ECardinalDirections::NONE);
 		}
-		else
+	}
+	for (const TPair<int32, uint8>& newArrow : newPathArrows)
+	{
+		const uint8* displayedState = DisplayedPathArrows.Find(newArrow.Key);
+		AGameTile* tile = !displayedState || *displayedState != newArrow.Value ? TileGrid->GetTile(newArrow.Key) : nullptr;
+		if (tile)
 		{
-			// there is a tile after this one
-			auto* nextTile = NewPath[i + 1];
-			if (southTile == nextTile)
-			{
-				// the path continues to the south
-				target = ECardinalDirections::DOWN_DIR;
-			}
-			else if (eastTile == nextTile)
-			{
-				// the path continues to the east
-				target = ECardinalDirections::RIGHT_DIR;
+			tile->TriggerTilePathing(true, (ECardinalDirections)(newArrow.Value >> 4), (ECardinalDirections)(newArrow.Value & 0x0F));	// signal to display arrows to the tile
+		}
+	}
 
-			}
-			else if (westTile == nextTile)
-			{
-				// the path continues to the west
-				target = ECardinalDirections::LEFT_DIR;
+	DisplayedPathArrows = MoveTemp(newPathArrows);
+	CurrentPathTiles = MoveTemp(newPathTiles);
+}
 
-			}
-			else if (northTile == nextTile)
+void UPlayerPathControl::ClearPathDisplays()
+{
+	if (TileGrid)
+	{
+		for (const TPair<int32, uint8>& displayedArrow : DisplayedPathArrows)
+		{
+			if (AGameTile* tile = TileGrid->GetTile(displayedArrow.Key)) // the tile may have been unregistered since it was displayed
 			{
-				// the path continues to the north
-				target = ECardinalDirections::UP_DIR;
+				tile->TriggerTilePathing(false, ECardinalDirections::NONE, ECardinalDirections::NONE);
 			}
 		}
-
-		currentTile->TriggerTilePathing(true, origin, target);	// signal to display arrows to the tile
 	}
+	DisplayedPathArrows.Reset();
 }
 
-bool UPlayerPathControl::CalculateNewPathToReachTile(const TArray<AGameTile*> Path, const AGameTile* TargetTile, TArray<AGameTile*>& NewPath)
+bool UPlayerPathControl::CalculateNewPathToReachTile(const TArray<AGameTile*>& Path, const AGameTile* TargetTile, TArray<AGameTile*>& NewPath)
 {
-	if (Path.Num() == 0)
+	if (Path.Num() == 0 || !TileGrid || !SelectedUnit)
 		return false; // Path should always at least have a starting tile
 
-	AGameTile* lastTile = Path.Top();
-
-	TArray<AGameTile*> newPath;
-	uint8 newPathLen;
-	if (FindPathToReachTileLoop(lastTile, TargetTile, 0, MaxMovementDist - Path.Num() + 1, Path, newPath, newPathLen))
+	const int32 toIndex = TileGrid->GetTileIndex(TargetTile);
+	if (toIndex == INDEX_NONE)
 	{
-		NewPath = newPath;
-		return true;
+		return false;
 	}
 
-	return false;
-}
-
-bool UPlayerPathControl::FindPathToReachTileLoop(AGameTile* CurrentTile, const AGameTile* TargetTile, 
-	const uint8 PathLength, const uint8 MaxPathLength, const TArray<AGameTile*> SearchPath, TArray<AGameTile*>& FoundPath, uint8& FoundPathLength)
-{
-	if (!CurrentTile || PathLength > MaxPathLength || (SearchPath.Contains(CurrentTile) && PathLength != 0) || !CurrentTile->GetIsNavigable())
+	TArray<int32> pathIndices;
+	pathIndices.Reserve(Path.Num());
+	for (auto* tile : Path)
 	{
-		return false;
+		const int32 tileIndex = TileGrid->GetTileIndex(tile);
+		if (tileIndex == INDEX_NONE)
+		{
+			return false;
+		}
+		pathIndices.Add(tileIndex);
 	}
 
-	if (CurrentTile == TargetTile)
+	FTilePathQuery query;
+	query.ToTile = toIndex;
+	query.MoveBudget = MaxMovementDist;
+	query.MoveCosts = SelectedUnit->GetUnitMoveCostTable();
+	if (const FMovementCostTable* costTable = SelectedUnit->GetUnitCostTable())
 	{
-		// path is found
-		FoundPath = SearchPath;
-		FoundPath.Add(CurrentTile);
-		FoundPathLength = PathLength;
-		return true;
+		query.SetTileCosts(TileGrid->GetMoveCostGrid(*costTable));
 	}
+	query.AllowedTiles = &TileControlPawn->GetNavigableTiles();
 
-	TArray<AGameTile*> newCurrentPath = SearchPath;
-
-	if (!SearchPath.Contains(CurrentTile)) // only add this tile to the path if this isn't the first loop (avoids a duplicate in FoundPath)
-		newCurrentPath.Add(CurrentTile);
-
-	// continuing to find the best path
-	auto* northTile = CurrentTile->GetNorthTile();
-	auto* southTile = CurrentTile->GetSouthTile();
-	auto* eastTile = CurrentTile->GetEastTile();
-	auto* westTile = CurrentTile->GetWestTile();
+	// the path priority depends on the current camera rotation. prioritize paths where units move horizontally before vertically since it is easier to visualize from the top-down diagonal view
+	const ECardinalDirections currentCamSetting = TileControlPawn->GetCurrentCameraRotation();
+	FTilePathPlanner::GetCameraDirectionPriority(currentCamSetting == ECardinalDirections::UP_DIR || currentCamSetting == ECardinalDirections::DOWN_DIR, query.DirectionPriority);
 
-	TArray<AGameTile*> northPath, southPath, eastPath, westPath;
-	uint8 northPathLen = 255, southPathLen = 255, eastPathLen = 255, westPathLen = 255;
-	bool isPathNorth, isPathSouth, isPathEast, isPathWest;
+	int32 prefixLength;
+	TArray<int32> detour;
+	if (!PathPlanner.FindPathKeepingPrefix(TileGrid->GetGridData(), query, pathIndices, prefixLength, detour))
+	{
+		return false;
+	}
 
-	isPathNorth = FindPathToReachTileLoop(northTile, TargetTile, PathLength + 1, MaxPathLength, newCurrentPath, northPath, northPathLen);
-	isPathSouth = FindPathToReachTileLoop(southTile, TargetTile, PathLength + 1, MaxPathLength, newCurrentPath, southPath, southPathLen);
-	isPathEast = FindPathToReachTileLoop(eastTile, TargetTile, PathLength + 1, MaxPathLength, newCurrentPath, eastPath, eastPathLen);
-	isPathWest = FindPathToReachTileLoop(westTile, TargetTile, PathLength + 1, MaxPathLength, newCurrentPath, westPath, westPathLen);
+	NewPath.Reset(prefixLength + detour.Num());
+	NewPath.Append(Path.GetData(), prefixLength);
+	for (int32 tileIndex : detour)
+	{
+		NewPath.Add(TileGrid->GetTile(tileIndex));
+	}
+	return true;
+}
 
-	// the path priority depends on the current camera rotation. prioritize paths where units move horizontally before vertically since it is easier to visualize from the top-down diagonal view
-	ECardinalDirections currentCamSetting = TileControlPawn->GetCurrentCameraRotation();
+int32 UPlayerPathControl::GetTileMoveCost(const AGameTile* Tile) const
+{
+	const int32 tileIndex = TileGrid ? TileGrid->GetTileIndex(Tile) : INDEX_NONE;
+	const TConstArrayView<uint8> moveCosts = SelectedUnit ? SelectedUnit->GetUnitMoveCostTable() : TConstArrayView<uint8>();
+	if (tileIndex == INDEX_NONE || moveCosts.Num() < 256)
+	{
+		return 255;
+	}
+	return moveCosts[TileGrid->GetGridData().TerrainTypes[tileIndex]];
+}
 
-	if (currentCamSetting == ECardinalDirections::UP_DIR || currentCamSetting == ECardinalDirections::DOWN_DIR)
+int32 UPlayerPathControl::GetPathMoveCost(const TArray<AGameTile*>& Path) const
+{
+	int32 pathCost = 0;
+	for (int32 i = 1; i < Path.Num(); i++)
 	{
-		// priority is west/east/south/north
-		if (isPathWest && westPathLen <= FMath::Min3(eastPathLen, southPathLen, northPathLen))
-		{
-			FoundPath = westPath;
-			FoundPathLength = westPathLen;
-			return true;
-		}
-		else if (isPathEast && eastPathLen <= FMath::Min(southPathLen, northPathLen))
-		{
-			FoundPath = eastPath;
-			FoundPathLength = eastPathLen;
-			return true;
-		}
-		else if (isPathSouth && southPathLen <= northPathLen)
-		{
-			FoundPath = southPath;
-			FoundPathLength = southPathLen;
-			return true;
-		}
-		else if (isPathNorth)
-		{
-			FoundPath = northPath;
-			FoundPathLength = northPathLen;
-			return true;
-		}
+		pathCost += GetTileMoveCost(Path[i]);
 	}
-	else
+	return pathCost;
+}
+
+bool UPlayerPathControl::IsTileOnCurrentPath(const AGameTile* Tile) const
+{
+	const int32 tileIndex = TileGrid ? TileGrid->GetTileIndex(Tile) : INDEX_NONE;
+	if (tileIndex == INDEX_NONE)
 	{
-		// priority is north/south/east/west
+		return CurrentPath.Contains(Tile);	// tile is not part of the indexed grid
+	}
+	return CurrentPathTiles.Contains(tileIndex);
+}
 
-		if (isPathNorth && northPathLen <= FMath::Min3(southPathLen, eastPathLen, westPathLen))
-		{
-			FoundPath = northPath;
-			FoundPathLength = northPathLen;
-			return true;
-		}
-		else if (isPathSouth && southPathLen <= FMath::Min(eastPathLen, westPathLen))
-		{
-			FoundPath = southPath;
-			FoundPathLength = southPathLen;
-			return true;
-		}
-		else if (isPathEast && eastPathLen <= westPathLen)
-		{
-			FoundPath = eastPath;
-			FoundPathLength = eastPathLen;
-			return true;
-		}
-		else if (isPathWest)
+void UPlayerPathControl::ResetCurrentPathTiles()
+{
+	CurrentPathTiles.Init(TileGrid ? TileGrid->GetTileCount() : 0);
+	for (auto* tile : CurrentPath)
+	{
+		const int32 tileIndex = TileGrid ? TileGrid->GetTileIndex(tile) : INDEX_NONE;
+		if (tileIndex != INDEX_NONE)
 		{
-			FoundPath = westPath;
-			FoundPathLength = westPathLen;
-			return true;
+			CurrentPathTiles.Add(tileIndex);
 		}
 	}
-
-	// no path found
-	FoundPathLength = 255;
-	return false;
 }
 
 void UPlayerPathControl::UnitMovedToTile(AGameTile* Tile)
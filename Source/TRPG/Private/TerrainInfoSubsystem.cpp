@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainInfoSubsystem.h"
+#include "TileGridSubsystem.h"
+
+void UTerrainInfoSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TileGrid = Collection.InitializeDependency<UTileGridSubsystem>();
+	InvalidateTerrainInfo();
+}
+
+void UTerrainInfoSubsystem::BakeTerrainInfo()
+{
+	if (!TileGrid)
+	{
+		return;
+	}
+
+	// One tile per terrain type is enough - only the terrain type decides the answer
+	const FTileGridData& gridData = TileGrid->GetGridData();
+	for (int32 tileIndex = 0; tileIndex < gridData.Num(); tileIndex++)
+	{
+		const uint8 terrainType = gridData.TerrainTypes[tileIndex];
+		if (terrainType != 255 && !HudInfoValid[terrainType])	// 255 - the tile has not reported its terrain yet
+		{
+			if (AGameTile* tile = TileGrid->GetTile(tileIndex))
+			{
+				HudInfos[terrainType] = tile->GetTerrainInfoForHud();
+				HudInfoValid[terrainType] = true;
+			}
+		}
+	}
+}
+
+void UTerrainInfoSubsystem::InvalidateTerrainInfo()
+{
+	HudInfos.SetNum(256);
+	HudInfoValid.Init(false, 256);
+
+	for (int32 movementType = 0; movementType < 256; movementType++)
+	{
+		UnitInfos[movementType].Empty();
+		UnitInfoValid[movementType].Empty();
+	}
+}
+
+FTerrainInfo UTerrainInfoSubsystem::GetTerrainInfoForHud(AGameTile* Tile)
+{
+	if (!Tile)
+	{
+		return FTerrainInfo();
+	}
+
+	const uint8 terrainType = AGameTile::GetTerrainTypeAsByte(Tile);
+	if (terrainType == 255)
+	{
+		return Tile->GetTerrainInfoForHud();	// terrain not known yet - nothing to key the cache on
+	}
+
+	if (!HudInfoValid[terrainType])
+	{
+		HudInfos[terrainType] = Tile->GetTerrainInfoForHud();	// this tile has the terrain - no need to search for one
+		HudInfoValid[terrainType] = true;
+	}
+	return HudInfos[terrainType];
+}
+
+FTerrainInfo UTerrainInfoSubsystem::GetTerrainInfoForUnit(AGameTile* Tile, uint8 UnitMovementType)
+{
+	if (!Tile)
+	{
+		return FTerrainInfo();
+	}
+
+	const uint8 terrainType = AGameTile::GetTerrainTypeAsByte(Tile);
+	if (terrainType == 255)
+	{
+		return Tile->GetTerrainInfoForUnit(UnitMovementType);	// terrain not known yet - nothing to key the cache on
+	}
+
+	TArray<FTerrainInfo>& unitInfos = UnitInfos[UnitMovementType];
+	TBitArray<>& unitInfoValid = UnitInfoValid[UnitMovementType];
+	if (unitInfos.IsEmpty())
+	{
+		unitInfos.SetNum(256);
+		unitInfoValid.Init(false, 256);
+	}
+
+	if (!unitInfoValid[terrainType])
+	{
+		unitInfos[terrainType] = Tile->GetTerrainInfoForUnit(UnitMovementType);
+		unitInfoValid[terrainType] = true;
+	}
+	return unitInfos[terrainType];
+}
@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThreatMapSubsystem.h"
+#include "GameTile.h"
+#include "TileGridSubsystem.h"
+#include "TileOverlaySubsystem.h"
+#include "UnitRegistrySubsystem.h"
+
+void UThreatMapSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TileGrid = Collection.InitializeDependency<UTileGridSubsystem>();
+	if (TileGrid)
+	{
+		TileChangedHandle = TileGrid->OnTileChanged.AddUObject(this, &UThreatMapSubsystem::OnTileChanged);
+	}
+}
+
+void UThreatMapSubsystem::Deinitialize()
+{
+	if (TileGrid)
+	{
+		TileGrid->OnTileChanged.Remove(TileChangedHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UThreatMapSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bDisplayThreats)
+	{
+		UpdateThreatMap();
+	}
+}
+
+TStatId UThreatMapSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UThreatMapSubsystem, STATGROUP_Tickables);
+}
+
+void UThreatMapSubsystem::SetThreatDisplayEnabled(bool bEnabled)
+{
+	if (bDisplayThreats == bEnabled)
+	{
+		return;
+	}
+
+	UpdateThreatMap();
+	bDisplayThreats = bEnabled;
+
+	if (auto* overlays = GetWorld()->GetSubsystem<UTileOverlaySubsystem>())
+	{
+		for (int32 tileIndex = 0; tileIndex < ThreatCounts.Num(); tileIndex++)
+		{
+			if (ThreatCounts[tileIndex] > 0)
+			{
+				overlays->SetTileOverlayFlag(tileIndex, OVERLAY_THREATENED, bEnabled);
+			}
+		}
+	}
+}
+
+void UThreatMapSubsystem::ToggleThreatDisplay()
+{
+	SetThreatDisplayEnabled(!bDisplayThreats);
+}
+
+int32 UThreatMapSubsystem::GetThreatCount(int32 TileIndex)
+{
+	UpdateThreatMap();
+	return ThreatCounts.IsValidIndex(TileIndex) ? ThreatCounts[TileIndex] : 0;
+}
+
+void UThreatMapSubsystem::RebuildThreatMap()
+{
+	for (FUnitThreat& threat : UnitThreats)
+	{
+		RemoveUnitThreat(threat);
+	}
+	UnitThreats.Reset();
+
+	const int32 tileCount = TileGrid ? TileGrid->GetTileCount() : 0;
+	if (ThreatCounts.Num() != tileCount)
+	{
+		ThreatCounts.Init(0, tileCount);
+		ChangedTileSet.Init(tileCount);
+	}
+	ChangedTiles.Reset();
+	ChangedTileSet.Reset();
+	bNeedsRebuild = false;
+
+	auto* registry = GetWorld()->GetSubsystem<UUnitRegistrySubsystem>();
+	if (!registry)
+	{
+		return;
+	}
+	for (AGameUnit* unit : registry->GetFactionUnits(ThreatFaction))
+	{
+		if (IsThreatUnit(unit) && TileGrid->GetTileIndex(unit->GetCurrentUnitTile()) != INDEX_NONE)
+		{
+			FUnitThreat& threat = UnitThreats.AddDefaulted_GetRef();
+			threat.Unit = unit;
+			ComputeUnitThreat(threat);
+		}
+	}
+}
+
+void UThreatMapSubsystem::UpdateThreatMap()
+{
+	if (!TileGrid)
+	{
+		return;
+	}
+	if (bNeedsRebuild || ThreatCounts.Num() != TileGrid->GetTileCount())
+	{
+		RebuildThreatMap();
+		return;
+	}
+
+	// Threatening units that arrived on a changed tile and are not tracked yet
+	for (int32 tileIndex : ChangedTiles)
+	{
+		AGameUnit* unit = TileGrid->GetTileOccupant(tileIndex);
+		if (IsThreatUnit(unit) && !UnitThreats.ContainsByPredicate([unit](const FUnitThreat& Threat) { return Threat.Unit.Get() == unit; }))
+		{
+			FUnitThreat& threat = UnitThreats.AddDefaulted_GetRef();
+			threat.Unit = unit;
+		}
+	}
+
+	for (int32 threatIndex = UnitThreats.Num() - 1; threatIndex >= 0; threatIndex--)
+	{
+		FUnitThreat& threat = UnitThreats[threatIndex];
+		AGameUnit* unit = threat.Unit.Get();
+		const int32 unitTile = IsThreatUnit(unit) ? TileGrid->GetTileIndex(unit->GetCurrentUnitTile()) : INDEX_NONE;
+		if (unitTile == INDEX_NONE)
+		{
+			RemoveUnitThreat(threat);	// died, left the map or changed sides
+			UnitThreats.RemoveAtSwap(threatIndex);
+			continue;
+		}
+
+		bool bAffected = unitTile != threat.StartTile;
+		for (int32 changedIndex = 0; changedIndex < ChangedTiles.Num() && !bAffected; changedIndex++)
+		{
+			bAffected = threat.ExploredTiles.Contains(ChangedTiles[changedIndex]);
+		}
+		if (bAffected)
+		{
+			ComputeUnitThreat(threat);
+		}
+	}
+
+	for (int32 tileIndex : ChangedTiles)
+	{
+		ChangedTileSet.Remove(tileIndex);
+	}
+	ChangedTiles.Reset();
+}
+
+void UThreatMapSubsystem::OnTileChanged(int32 TileIndex)
+{
+	if (bNeedsRebuild || TileIndex >= ChangedTileSet.Num() || ChangedTileSet.Contains(TileIndex))
+	{
+		return;	// the next update rebuilds everything anyway, or the tile is already queued
+	}
+
+	ChangedTileSet.Add(TileIndex);
+	ChangedTiles.Add(TileIndex);
+}
+
+void UThreatMapSubsystem::ComputeUnitThreat(FUnitThreat& Threat)
+{
+	RemoveUnitThreat(Threat);
+
+	AGameUnit* unit = Threat.Unit.Get();
+	Threat.StartTile = unit ? TileGrid->GetTileIndex(unit->GetCurrentUnitTile()) : INDEX_NONE;
+	if (Threat.StartTile == INDEX_NONE)
+	{
+		return;
+	}
+
+	FTileReachabilityQuery query;
+	unit->MakeReachabilityQuery(*TileGrid, Threat.StartTile, unit->BaseMovementSpaces, true, query);
+	query.bCollectRangeTiles = true;
+	TileGrid->ComputeReachability(query, SearchResult);
+
+	// The search read every reached tile and each of their neighbors - blocked and occupied ones included
+	const FTileGridData& gridData = TileGrid->GetGridData();
+	Threat.ExploredTiles.Init(gridData.Num());
+	for (int32 tileIndex : SearchResult.NavigableTiles)
+	{
+		Threat.ExploredTiles.Add(tileIndex);
+		for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+		{
+			const int32 neighborIndex = gridData.GetNeighbor(tileIndex, (ETileNeighbor)dir);
+			if (neighborIndex != INDEX_NONE)
+			{
+				Threat.ExploredTiles.Add(neighborIndex);
+			}
+		}
+	}
+
+	Threat.ThreatenedTiles = SearchResult.RangeTiles;
+	for (int32 tileIndex : Threat.ThreatenedTiles)
+	{
+		AddThreat(tileIndex, 1);
+	}
+}
+
+void UThreatMapSubsystem::RemoveUnitThreat(FUnitThreat& Threat)
+{
+	for (int32 tileIndex : Threat.ThreatenedTiles)
+	{
+		AddThreat(tileIndex, -1);
+	}
+	Threat.ThreatenedTiles.Reset();
+	Threat.StartTile = INDEX_NONE;
+}
+
+void UThreatMapSubsystem::AddThreat(int32 TileIndex, int32 Delta)
+{
+	if (!ThreatCounts.IsValidIndex(TileIndex))
+	{
+		return;
+	}
+
+	const uint16 oldCount = ThreatCounts[TileIndex];
+	ThreatCounts[TileIndex] = (uint16)FMath::Max((int32)oldCount + Delta, 0);
+
+	const bool bWasThreatened = oldCount > 0;
+	const bool bIsThreatened = ThreatCounts[TileIndex] > 0;
+	if (bDisplayThreats && bWasThreatened != bIsThreatened)
+	{
+		if (auto* overlays = GetWorld()->GetSubsystem<UTileOverlaySubsystem>())
+		{
+			overlays->SetTileOverlayFlag(TileIndex, OVERLAY_THREATENED, bIsThreatened);
+		}
+	}
+}
+
+bool UThreatMapSubsystem::IsThreatUnit(const AGameUnit* Unit) const
+{
+	return IsValid(Unit) && Unit->UnitFaction == ThreatFaction;
+}
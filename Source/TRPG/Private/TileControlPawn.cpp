@@ -2,6 +2,11 @@
 
 #include "TileControlPawn.h"
 #include "PlayerPathControl.h"
+#include "TileGridSubsystem.h"
+#include "TileOverlaySubsystem.h"
+#include "MovementClassAsset.h"
+#include "TileReachabilitySubsystem.h"
+#include "ThreatMapSubsystem.h"
 
 // Sets default values
 ATileControlPawn::ATileControlPawn()
@@ -39,6 +44,8 @@ ATileControlPawn::ATileControlPawn()
 void ATileControlPawn::BeginPlay()
 {
 	Super::BeginPlay();
+
+	TileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();	// indexed tile data for neighbor lookups
 	
 	BindToCombatGameMode();	// link to the game mode to listen to phase-changes
 
@@ -128,6 +135,9 @@ bool ATileControlPawn::BindInputsToOwnerController()
 			// Action input
 			gameController->OnConfirmPress.AddDynamic(this, &ATileControlPawn::InputSelectTile);
 			gameController->OnCancelPress.AddDynamic(this, &ATileControlPawn::InputCancelTile);
+
+			// Displays
+			gameController->OnToggleDisplayPress.AddDynamic(this, &ATileControlPawn::InputToggleThreatDisplay);
 		}
 	}
 
@@ -299,169 +309,130 @@ void ATileControlPawn::CancelUnitTargetingPhase()
 
 }
 
-void ATileControlPawn::GetAvailableTilesForSelectedUnit(AGameTile* SelectedTile, AGameUnit* CurrentSelectedUnit, TArray<AGameTile*>& FoundNavigableTiles, TArray<AGameTile*>& FoundAttackableTiles, TArray<AGameTile*>& FoundInteractableTiles)
+void ATileControlPawn::GetAvailableTilesForSelectedUnit(AGameTile* SelectedTile, AGameUnit* CurrentSelectedUnit, FTileBitset& FoundNavigableTiles, FTileBitset& FoundAttackableTiles, FTileBitset& FoundInteractableTiles, FTileReachabilityResult& Reachability)
 {
+	Reachability.Reset();
+
 	if (!CurrentSelectedUnit || !SelectedTile)
 	{
 		return;
 	}
 
-	uint8 remainingMoves = AGameUnit::GetUnitRemainingSpaces(CurrentSelectedUnit) + 1;
-	uint8 remainingActions = AGameUnit::GetUnitRemainingActions(CurrentSelectedUnit);
-	uint8 minAtkRange = 0, maxAtkRange = 0;
-	bool weaponTargetsAllies = false, weaponTargetsEnemies = false;
-	bool hasWeapon;
-	if (remainingActions > 0)
-		hasWeapon = CurrentSelectedUnit->GetUnitEquippedWeaponRange(minAtkRange, maxAtkRange, weaponTargetsEnemies, weaponTargetsAllies);	// get weapon data only if an action is available
-	else
-		hasWeapon = false;	// skip getting weapon data - no actions left
-
-	TArray<AGameTile*> navigableTiles = TArray<AGameTile*>();
-	TArray<AGameTile*> attackableTiles = TArray<AGameTile*>();
-	TArray<AGameTile*> interactableTiles = TArray<AGameTile*>();
-	TArray<AGameTile*> checkedTiles = TArray<AGameTile*>();
-
-
-	uint8 maxDistanceToConsider = FMath::Max(remainingMoves + maxAtkRange, remainingMoves + 1);	// Only consider tiles within the movement/attack range or movement/interact range
-
-	// Calculate navigable tiles
-	GetAvailableTilesLoop(CurrentSelectedUnit, SelectedTile, maxDistanceToConsider, 0, remainingMoves, 1, minAtkRange, maxAtkRange, weaponTargetsEnemies, weaponTargetsAllies, navigableTiles, attackableTiles, interactableTiles, checkedTiles);
-
-	for (AGameTile* navigableTile : navigableTiles)
+	auto* tileGrid = SelectedTile->GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	const int32 startIndex = tileGrid ? tileGrid->GetTileIndex(SelectedTile) : INDEX_NONE;
+	if (startIndex == INDEX_NONE)
 	{
-		navigableTile->TriggerTileNavigable(true);
-	}
-	for (AGameTile* attackableTile : attackableTiles)
-	{
-		attackableTile->TriggerTileAttackable(true);
+		UE_LOG(LogTemp, Warning, TEXT("Selected tile is not part of the tile grid - no tiles to display"));
+		return;
 	}
-	for (AGameTile* interactableTile : interactableTiles)
+
+	FTileReachabilityQuery query;
+	CurrentSelectedUnit->MakeSelectionQuery(*tileGrid, startIndex, query);
+
+	// Reselecting a unit with nothing changed on the map, or selecting one precomputed at the start of the phase, reuses the stored result
+	if (auto* reachability = SelectedTile->GetWorld()->GetSubsystem<UTileReachabilitySubsystem>())
 	{
-		interactableTile->TriggerTileInteractable(true);
+		const FMovementCostTable* costTable = CurrentSelectedUnit->GetUnitCostTable();
+		const FCachedReachability& cached = reachability->GetReachability(CurrentSelectedUnit, query, costTable ? costTable->Version : 0);
+
+		Reachability = cached.Result;
+		FoundNavigableTiles = cached.NavigableTiles;
+		FoundAttackableTiles = cached.AttackableTiles;
+		FoundInteractableTiles = cached.InteractableTiles;
+		return;
 	}
 
-	FoundNavigableTiles = navigableTiles;
-	FoundAttackableTiles = attackableTiles;
-	FoundInteractableTiles = interactableTiles;
+	// No cache in this world - search directly
+	FCachedReachability found;
+	tileGrid->ComputeReachability(query, found.Result);
+	found.BuildTileSets(tileGrid->GetTileCount());
+
+	Reachability = MoveTemp(found.Result);
+	FoundNavigableTiles = MoveTemp(found.NavigableTiles);
+	FoundAttackableTiles = MoveTemp(found.AttackableTiles);
+	FoundInteractableTiles = MoveTemp(found.InteractableTiles);
 }
 
-void ATileControlPawn::GetAvailableTilesLoop(AGameUnit* CurrentSelectedUnit, AGameTile* CurrentTile, uint8 MaxTileDistance, uint8 CurrentTileDistance, uint8 NavigationDistance, uint8 InteractionDistance, uint8 WeaponActDistanceMin, uint8 WeaponActInstanceMax, bool weaponTargetsEnemies, bool weaponTargetsAllies,
-	TArray<AGameTile*>& FoundNavigableTiles, TArray<AGameTile*>& FoundAttackableTiles, TArray<AGameTile*>& FoundInteractableTiles, TArray<AGameTile*> checkedTiles)
+void ATileControlPawn::SetHighlightedTiles(const FTileBitset& NewNavigableTiles, const FTileBitset& NewAttackableTiles, const FTileBitset& NewInteractableTiles)
 {
-	if (!CurrentTile)
-		return;
-
-	if (CurrentTileDistance > MaxTileDistance)
+	auto* overlays = GetWorld()->GetSubsystem<UTileOverlaySubsystem>();
+	if (!TileGrid || !overlays)
 	{
 		return;
 	}
 
-	bool tileHasAlly = false, tileHasEnemy = false;	// track if the tile has an enemy/ally for deciding navigation paths later.
-
-	AGameUnit* tileUnit;
-	if (CurrentTile->GetUnitOnTile(tileUnit))	// Checked tile has a unit on it
-	{
-		// Check the current tile for an enemy/ally that the current-equipped weapon can act with
-		
-		if (tileUnit->UnitFaction == EUnitFaction::ENEMY)	// enemy unit
+	// Only tiles whose highlight changed are queued - a word-wide difference in each direction finds them.
+	// The overlay subsystem sends every change of the frame as one batched event.
+	auto updateTiles = [this, overlays](FTileBitset& CurrentTiles, const FTileBitset& NewTiles, ETileOverlayFlags Flag)
 		{
-			tileHasEnemy = true;
+			FTileBitset changedTiles;
 
-			// target is an enemy and is attackable if the weapon equipped can target enemies.
-			if (CurrentTileDistance >= WeaponActDistanceMin && CurrentTileDistance <= WeaponActInstanceMax && weaponTargetsEnemies) // in weapon range
-			{
-				FoundAttackableTiles.AddUnique(CurrentTile);
-			}
-		}
-		if ((tileUnit->UnitFaction == EUnitFaction::PLAYER || tileUnit->UnitFaction == EUnitFaction::PARTNER))	// ally unit
-		{
-			tileHasAlly = true;
+			FTileBitset::Difference(CurrentTiles, NewTiles, changedTiles);
+			changedTiles.ForEachSetBit([overlays, Flag](int32 TileIndex)
+				{
+					overlays->SetTileOverlayFlag(TileIndex, Flag, false);
+				});
+
+			FTileBitset::Difference(NewTiles, CurrentTiles, changedTiles);
+			changedTiles.ForEachSetBit([overlays, Flag](int32 TileIndex)
+				{
+					overlays->SetTileOverlayFlag(TileIndex, Flag, true);
+				});
 
-			// target is an ally and is actionable if the weapon equipped can target allies
-			if (CurrentTileDistance >= WeaponActDistanceMin && CurrentTileDistance <= WeaponActInstanceMax && weaponTargetsAllies) // in weapon range
+			CurrentTiles = NewTiles;
+			if (CurrentTiles.Num() != TileGrid->GetTileCount())
 			{
-				FoundInteractableTiles.AddUnique(CurrentTile);
+				CurrentTiles.Init(TileGrid->GetTileCount());
 			}
-		}
-	}
+		};
 
-	checkedTiles.AddUnique(CurrentTile); // consider tile checked - so inner loops do not return to this tile
+	updateTiles(NavigableTiles, NewNavigableTiles, OVERLAY_NAVIGABLE);
+	updateTiles(AttackableTiles, NewAttackableTiles, OVERLAY_ATTACKABLE);
+	updateTiles(InteractableTiles, NewInteractableTiles, OVERLAY_INTERACTABLE);
+}
 
-	uint8 unitMoveCostOnTile = CurrentSelectedUnit->GetUnitMovementForTile(AGameTile::GetTerrainTypeAsByte(CurrentTile));
+void ATileControlPawn::ClearSelectedTileData()
+{
+	const FTileBitset noTiles;
+	SetHighlightedTiles(noTiles, noTiles, noTiles);
+}
 
-	// Tile is navigable if there is no enemy
-	if (!tileHasEnemy && unitMoveCostOnTile != 255 && (CurrentTileDistance < NavigationDistance))
-	{
-		FoundNavigableTiles.AddUnique(CurrentTile);
-	}
-	if (tileHasEnemy || unitMoveCostOnTile == 255 || (CurrentTileDistance + unitMoveCostOnTile >= NavigationDistance)) // continue checking tiles without movement
-	{
-		// continue iterations if the tile has enemies, but do not consider walking past the unit
-		if (!checkedTiles.Contains(CurrentTile->GetNorthTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetNorthTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, 0, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-		if (!checkedTiles.Contains(CurrentTile->GetSouthTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetNorthTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, 0, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-		if (!checkedTiles.Contains(CurrentTile->GetEastTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetNorthTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, 0, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-		if (!checkedTiles.Contains(CurrentTile->GetWestTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetNorthTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, 0, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-	}
-	else
-	{
-		// continue iterations. 
-		if (!checkedTiles.Contains(CurrentTile->GetNorthTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetNorthTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, NavigationDistance, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-		if (!checkedTiles.Contains(CurrentTile->GetSouthTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetSouthTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, NavigationDistance, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-		if (!checkedTiles.Contains(CurrentTile->GetEastTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetEastTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, NavigationDistance, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-		if (!checkedTiles.Contains(CurrentTile->GetWestTile()))
-		{
-			GetAvailableTilesLoop(CurrentSelectedUnit, CurrentTile->GetWestTile(), MaxTileDistance, CurrentTileDistance + unitMoveCostOnTile, NavigationDistance, InteractionDistance, WeaponActDistanceMin, WeaponActInstanceMax,
-				weaponTargetsEnemies, weaponTargetsAllies, FoundNavigableTiles, FoundAttackableTiles, FoundInteractableTiles, checkedTiles);
-		}
-	}
+const FTileBitset& ATileControlPawn::GetNavigableTiles() const
+{
+	return NavigableTiles;
+}
 
+const FTileReachabilityResult& ATileControlPawn::GetSelectedUnitReachability() const
+{
+	return SelectedUnitReachability;
 }
 
-void ATileControlPawn::ClearSelectedTileData()
+AGameTile* ATileControlPawn::GetAdjacentTile(AGameTile* Tile, ETileNeighbor Direction) const
 {
-	for (AGameTile* navigableTile : NavigableTiles)
+	if (TileGrid && TileGrid->GetTileIndex(Tile) != INDEX_NONE)
 	{
-		navigableTile->TriggerTileNavigable(false);
+		return TileGrid->GetNeighborTile(Tile, Direction);
 	}
-	for (AGameTile* attackableTile : AttackableTiles)
+
+	if (!Tile)
 	{
-		attackableTile->TriggerTileAttackable(false);
+		return nullptr;
 	}
-	for (AGameTile* interactableTile : InteractableTiles)
+
+	// Tile is not indexed - fall back to the tile's own links
+	switch (Direction)
 	{
-		interactableTile->TriggerTileInteractable(false);
+	case (NEIGHBOR_NORTH):
+		return Tile->GetNorthTile();
+	case (NEIGHBOR_WEST):
+		return Tile->GetWestTile();
+	case (NEIGHBOR_EAST):
+		return Tile->GetEastTile();
+	case (NEIGHBOR_SOUTH):
+		return Tile->GetSouthTile();
+	default:
+		return nullptr;
 	}
-	NavigableTiles.Empty();
-	AttackableTiles.Empty();
-	InteractableTiles.Empty();
 }
 
 void ATileControlPawn::SetCameraZoomSetting(FZoomLevelData CameraSetting)
@@ -532,16 +503,16 @@ void ATileControlPawn::CursorMoveUp()
 		switch (CurrentViewRotation)
 		{
 		case(ECardinalDirections::UP_DIR):
-				nextTile = HoverTile->GetNorthTile();
+				nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_NORTH);
 				break;
 		case(ECardinalDirections::RIGHT_DIR):
-			nextTile = HoverTile->GetWestTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_WEST);
 			break;
 		case(ECardinalDirections::DOWN_DIR):
-			nextTile = HoverTile->GetSouthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_SOUTH);
 			break;
 		case(ECardinalDirections::LEFT_DIR):
-			nextTile = HoverTile->GetEastTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_EAST);
 			break;
 		default:
 			UE_LOG(LogTemp, Warning, TEXT("COULD NOT DETERMINE CURRENT TileControlPawn ORIENTATION!"));
@@ -568,16 +539,16 @@ void ATileControlPawn::CursorMoveDown()
 		switch (CurrentViewRotation)
 		{
 		case(ECardinalDirections::UP_DIR):
-			nextTile = HoverTile->GetSouthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_SOUTH);
 			break;
 		case(ECardinalDirections::RIGHT_DIR):
-			nextTile = HoverTile->GetEastTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_EAST);
 			break;
 		case(ECardinalDirections::DOWN_DIR):
-			nextTile = HoverTile->GetNorthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_NORTH);
 			break;
 		case(ECardinalDirections::LEFT_DIR):
-			nextTile = HoverTile->GetWestTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_WEST);
 			break;
 		default:
 			UE_LOG(LogTemp, Warning, TEXT("COULD NOT DETERMINE CURRENT TileControlPawn ORIENTATION!"));
@@ -604,16 +575,16 @@ void ATileControlPawn::CursorMoveLeft()
 		switch (CurrentViewRotation)
 		{
 		case(ECardinalDirections::UP_DIR):
-			nextTile = HoverTile->GetWestTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_WEST);
 			break;
 		case(ECardinalDirections::RIGHT_DIR):
-			nextTile = HoverTile->GetSouthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_SOUTH);
 			break;
 		case(ECardinalDirections::DOWN_DIR):
-			nextTile = HoverTile->GetEastTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_EAST);
 			break;
 		case(ECardinalDirections::LEFT_DIR):
-			nextTile = HoverTile->GetNorthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_NORTH);
 			break;
 		default:
 			UE_LOG(LogTemp, Warning, TEXT("COULD NOT DETERMINE CURRENT TileControlPawn ORIENTATION!"));
@@ -640,16 +611,16 @@ void ATileControlPawn::CursorMoveRight()
 		switch (CurrentViewRotation)
 		{
 		case(ECardinalDirections::UP_DIR):
-			nextTile = HoverTile->GetEastTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_EAST);
 			break;
 		case(ECardinalDirections::RIGHT_DIR):
-			nextTile = HoverTile->GetNorthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_NORTH);
 			break;
 		case(ECardinalDirections::DOWN_DIR):
-			nextTile = HoverTile->GetWestTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_WEST);
 			break;
 		case(ECardinalDirections::LEFT_DIR):
-			nextTile = HoverTile->GetSouthTile();
+			nextTile = GetAdjacentTile(HoverTile, NEIGHBOR_SOUTH);
 			break;
 		default:
 			UE_LOG(LogTemp, Warning, TEXT("COULD NOT DETERMINE CURRENT TileControlPawn ORIENTATION!"));
@@ -819,6 +790,14 @@ void ATileControlPawn::InputCancelTile()
 	}
 }
 
+void ATileControlPawn::InputToggleThreatDisplay()
+{
+	if (auto* threatMap = GetWorld()->GetSubsystem<UThreatMapSubsystem>())
+	{
+		threatMap->ToggleThreatDisplay();
+	}
+}
+
 const AGameTile* ATileControlPawn::GetViewTile()
 {
 	return ViewTile;
@@ -873,6 +852,16 @@ void ATileControlPawn::SetHoverTile(AGameTile* Tile)
 	{
 		HoverTile->TriggerTileHover();
 		OnTileHover.Broadcast(HoverTile);
+
+		// Search a hovered unit's ranges in the background - selecting it or previewing its ranges then finds the result ready
+		AGameUnit* hoverUnit;
+		if (TileGrid && HoverTile->GetUnitOnTile(hoverUnit) && hoverUnit != SelectedUnit)
+		{
+			if (auto* reachability = GetWorld()->GetSubsystem<UTileReachabilitySubsystem>())
+			{
+				reachability->PrefetchReachability(hoverUnit, TileGrid->GetTileIndex(HoverTile));
+			}
+		}
 	}
 }
 
@@ -885,11 +874,18 @@ void ATileControlPawn::SetSelectedTile(AGameTile* Tile, AGameUnit* Unit)
 	SelectedTile = Tile;
 	SelectedUnit = Unit;
 	SelectedUnitDir = Unit ? Unit->GetCurrentUnitDirection() : ECardinalDirections::NONE;
-	ClearSelectedTileData();
 	if (SelectedTile)
 	{
 		SelectedTile->TriggerTileSelected();
-		GetAvailableTilesForSelectedUnit(SelectedTile, SelectedUnit, NavigableTiles, AttackableTiles, InteractableTiles);
+
+		FTileBitset newNavigableTiles, newAttackableTiles, newInteractableTiles;
+		GetAvailableTilesForSelectedUnit(SelectedTile, SelectedUnit, newNavigableTiles, newAttackableTiles, newInteractableTiles, SelectedUnitReachability);
+		SetHighlightedTiles(newNavigableTiles, newAttackableTiles, newInteractableTiles);	// tiles highlighted for both the old and new selection are left alone
+	}
+	else
+	{
+		ClearSelectedTileData();
+		SelectedUnitReachability.Reset();
 	}
 
 	OnUnitTileSelected.Broadcast(Tile, Unit);
@@ -902,9 +898,19 @@ void ATileControlPawn::SetSelectedTile(AGameTile* Tile, AGameUnit* Unit)
 
 void ATileControlPawn::SetUnitMovingToTile(AGameUnit* Unit, AGameTile* Tile, ECardinalDirections Direction)
 {
+	IsUnitMoving = true;
+
+	if (ACombatGameMode::IsFastForwardBattle(this))
+	{
+		// No travel animation - arrive now. The unit is only placed; the tile is confirmed when the move ends, as with the animated path.
+		Unit->SetActorLocation(Tile->UnitPositionComponent->GetComponentLocation());
+		Unit->SetCurrentUnitDirection(Direction);
+		Unit->OnTraveledToTile.Broadcast(Tile);	// continues the path or ends the move
+		return;
+	}
+
 	Unit->MoveUnitToTile(Tile);
 	Unit->SetCurrentUnitDirection(Direction);
-	IsUnitMoving = true;
 }
 
 void ATileControlPawn::SetUnitMovedToTile(AGameUnit* Unit, AGameTile* Tile)
@@ -943,6 +949,22 @@ void ATileControlPawn::SetUnitActionComplete(AGameUnit* Unit, bool AllowMovement
 	}
 }
 
+void ATileControlPawn::ClearUnitSelection()
+{
+	if (SelectedUnit && (IsUnitMoving || IsUnitChoosingAction || IsUnitChoosingActionTarget))
+	{
+		if (IsUnitMoving)
+		{
+			SelectedUnit->StopMovementToTiles();
+		}
+		IsUnitMoving = false;
+		IsUnitChoosingAction = false;
+		IsUnitChoosingActionTarget = false;
+		OnCancelUnitMovementAndAction.Broadcast();	// closes the path and the action menu
+	}
+	SetSelectedTile(nullptr, nullptr);
+}
+
 ECardinalDirections ATileControlPawn::GetCurrentCameraRotation()
 {
 	return CurrentViewRotation;
@@ -2,6 +2,28 @@
 
 
 #include "TileDataActor.h"
+#include "EngineUtils.h"
+#include "Serialization/CustomVersion.h"
+#include "TileGridSubsystem.h"
+#include "TileInstanceManager.h"
+
+// Custom version for the baked tile graph block - maps saved before it existed skip reading it
+namespace TileGraphVersion
+{
+	enum Type : int32
+	{
+		BeforeCustomVersion	= 0,
+		BakedTileGraph		= 1,
+		BakedLayoutHash		= 2,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	const FGuid GUID(0x6A3C1F52, 0x94B84E07, 0xA1D2C3F4, 0x5B7E9D10);
+}
+
+FCustomVersionRegistration GRegisterTileGraphVersion(TileGraphVersion::GUID, TileGraphVersion::LatestVersion, TEXT("TileGraphVersion"));
 
 // Sets default values
 ATileDataActor::ATileDataActor()
@@ -25,3 +47,99 @@ void ATileDataActor::Tick(float DeltaTime)
 
 }
 
+void ATileDataActor::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	BakeTileGraph();
+}
+
+void ATileDataActor::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	Ar.UsingCustomVersion(TileGraphVersion::GUID);
+	if (Ar.CustomVer(TileGraphVersion::GUID) >= TileGraphVersion::BakedTileGraph)
+	{
+		BakedGraphRecords.BulkSerialize(Ar);	// one contiguous block - loads without per-record work
+	}
+	if (Ar.CustomVer(TileGraphVersion::GUID) >= TileGraphVersion::BakedLayoutHash)
+	{
+		Ar << BakedTileLayoutHash;	// older bakes keep 0 and rebuild at runtime until the map is saved again
+	}
+}
+
+void ATileDataActor::BakeTileGraph()
+{
+	UWorld* world = GetWorld();
+	if (!world)
+	{
+		return;
+	}
+
+	// Instanced tiles keep their own records - a graph of the few facade tiles left in the level would shadow them
+	for (TActorIterator<ATileInstanceManager> it(world); it; ++it)
+	{
+		if (it->HasTileRecords())
+		{
+			BakedGraphTiles.Reset();
+			BakedGraphRecords.Reset();
+			BakedTileLayoutHash = 0;
+			return;
+		}
+	}
+
+	// Index the map the same way the runtime does, then store the result
+	TArray<AGameTile*> tiles;
+	FTileGridData gridData;
+	UTileGridSubsystem::BuildGridFromTiles(world, tiles, gridData);
+
+	for (int32 tileIndex = 0; tileIndex < tiles.Num(); tileIndex++)
+	{
+		gridData.TerrainTypes[tileIndex] = tiles[tileIndex]->GetTerrainTypeByte();	// blueprint terrain lookup happens here instead of at BeginPlay
+	}
+
+	BakedGraphTiles = tiles;
+	gridData.ExportRecords(BakedGraphRecords);
+	BakedTileLayoutHash = ComputeTileLayoutHash(world);
+}
+
+bool ATileDataActor::HasValidBakedTileGraph() const
+{
+	if (BakedGraphRecords.IsEmpty() || BakedGraphRecords.Num() != BakedGraphTiles.Num())
+	{
+		return false;
+	}
+
+	for (AGameTile* tile : BakedGraphTiles)
+	{
+		if (!tile)
+		{
+			return false;
+		}
+	}
+
+	// Tiles added, removed or moved after the bake change the layout - the stored adjacency would be stale
+	return BakedTileLayoutHash != 0 && BakedTileLayoutHash == ComputeTileLayoutHash(GetWorld());
+}
+
+uint32 ATileDataActor::ComputeTileLayoutHash(UWorld* World)
+{
+	if (!World)
+	{
+		return 0;
+	}
+
+	// Summed per-tile hashes so actor iteration order does not matter
+	uint32 coordHashSum = 0;
+	int32 tileCount = 0;
+	for (TActorIterator<AGameTile> it(World); it; ++it)
+	{
+		const FIntVector coord = UTileGridSubsystem::GetTileCoord(*it);
+		coordHashSum += FCrc::MemCrc32(&coord, sizeof(coord));
+		tileCount++;
+	}
+
+	const uint32 layoutHash = HashCombine(coordHashSum, GetTypeHash(tileCount));
+	return layoutHash != 0 ? layoutHash : 1;	// 0 marks a graph without a layout hash
+}
@@ -0,0 +1,410 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileGridSubsystem.h"
+#include "EngineUtils.h"
+#include "Algo/Sort.h"
+#include "GameTile.h"
+#include "GameUnit.h"
+#include "TileSpatialHashLinker.h"
+#include "TileDataActor.h"
+#include "TileInstanceManager.h"
+#include "MovementClassAsset.h"
+
+void UTileGridSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	RebuildTileGrid();
+}
+
+void UTileGridSubsystem::RebuildTileGrid()
+{
+	GridData.Reset();
+	Tiles.Reset();
+	TileOccupants.Reset();
+	TileInstanceManager = nullptr;
+	CostGrids.Reset();
+	TerrainEpoch++;
+	BumpWorldEpoch();
+
+	UWorld* world = GetWorld();
+	if (!world)
+	{
+		return;
+	}
+
+	// Instanced tiles replace the tile actors entirely
+	for (TActorIterator<ATileInstanceManager> it(world); it; ++it)
+	{
+		if (it->HasTileRecords())
+		{
+			LoadInstancedTiles(**it);
+			return;
+		}
+	}
+
+	// Prefer the tile graph baked into the tile data actor on save - it loads without sorting, linking or blueprint calls
+	for (TActorIterator<ATileDataActor> it(world); it; ++it)
+	{
+		if (it->HasValidBakedTileGraph())
+		{
+			LoadBakedTileGraph(**it);
+			return;
+		}
+	}
+
+	BuildGridFromTiles(world, Tiles, GridData);
+	TileOccupants.SetNumZeroed(Tiles.Num());
+}
+
+void UTileGridSubsystem::LoadBakedTileGraph(const ATileDataActor& TileData)
+{
+	GridData.ImportRecords(TileData.BakedGraphRecords);
+	Tiles = TileData.BakedGraphTiles;
+	TileOccupants.SetNumZeroed(Tiles.Num());
+
+	for (int32 tileIndex = 0; tileIndex < Tiles.Num(); tileIndex++)
+	{
+		AGameTile* tile = Tiles[tileIndex];
+		tile->TileIndex = tileIndex;
+		tile->SetTerrainType(GridData.TerrainTypes[tileIndex]);	// tiles skip the blueprint terrain lookup once this is set
+	}
+}
+
+void UTileGridSubsystem::LoadInstancedTiles(ATileInstanceManager& InstanceManager)
+{
+	TileInstanceManager = &InstanceManager;
+	GridData.ImportRecords(InstanceManager.TileRecords);
+	Tiles.SetNumZeroed(GridData.Num());
+	TileOccupants.SetNumZeroed(GridData.Num());
+
+	for (AGameTile* tile : InstanceManager.PlacedFacadeTiles)
+	{
+		if (tile && Tiles.IsValidIndex(tile->TileIndex))
+		{
+			RegisterTileFacade(tile->TileIndex, tile);
+			tile->SetTerrainType(GridData.TerrainTypes[tile->TileIndex]);
+		}
+	}
+}
+
+FIntVector UTileGridSubsystem::GetTileCoord(const AGameTile* Tile)
+{
+	const FVector loc = Tile->GetActorLocation();
+	const float spacing = FMath::Max(Tile->AdjacentTileDistance, 1.0f);
+	const float verticalRange = FMath::Max(Tile->AdjacentTileVerticalRange, 1.0f);
+	return FIntVector(FMath::RoundToInt(loc.X / spacing), FMath::RoundToInt(loc.Y / spacing), FMath::FloorToInt(loc.Z / verticalRange));
+}
+
+void UTileGridSubsystem::BuildGridFromTiles(UWorld* World, TArray<AGameTile*>& OutTiles, FTileGridData& OutGridData)
+{
+	OutTiles.Reset();
+	OutGridData.Reset();
+
+	TArray<AGameTile*> worldTiles;
+	for (TActorIterator<AGameTile> it(World); it; ++it)
+	{
+		worldTiles.Add(*it);
+	}
+
+	// Integer coordinates - X/Y quantized by the tile spacing and Z banded by the vertical trace range
+	TArray<FIntVector> coords;
+	coords.Reserve(worldTiles.Num());
+	for (AGameTile* tile : worldTiles)
+	{
+		coords.Add(GetTileCoord(tile));
+	}
+
+	// Order tiles by layer and row so neighboring tiles sit close together in every array
+	TArray<int32> order;
+	order.Reserve(worldTiles.Num());
+	for (int32 i = 0; i < worldTiles.Num(); i++)
+	{
+		order.Add(i);
+	}
+	Algo::Sort(order, [&coords](int32 A, int32 B)
+		{
+			const FIntVector& a = coords[A];
+			const FIntVector& b = coords[B];
+			if (a.Z != b.Z)
+				return a.Z < b.Z;
+			if (a.X != b.X)
+				return a.X < b.X;
+			return a.Y < b.Y;
+		});
+
+	OutTiles.Reserve(worldTiles.Num());
+	for (int32 sourceIndex : order)
+	{
+		AGameTile* tile = worldTiles[sourceIndex];
+		tile->TileIndex = OutGridData.AddTile(coords[sourceIndex], AGameTile::GetTerrainTypeAsByte(tile));
+		OutTiles.Add(tile);
+	}
+
+	OutGridData.BuildCellLookup();
+
+	// Neighbor links come from the spatial hash - no traces are needed
+	LinkTiles(OutTiles, OutGridData.Neighbors);
+}
+
+void UTileGridSubsystem::LinkWorldTileNeighbors(UWorld* World)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	// Every tile calls this from PreSave - only link the map once per save
+	if (UTileGridSubsystem* tileGrid = World->GetSubsystem<UTileGridSubsystem>())
+	{
+		if (tileGrid->LastLinkedFrame == GFrameCounter)
+		{
+			return;
+		}
+		tileGrid->LastLinkedFrame = GFrameCounter;
+	}
+
+	TArray<AGameTile*> worldTiles;
+	for (TActorIterator<AGameTile> it(World); it; ++it)
+	{
+		worldTiles.Add(*it);
+	}
+
+	TArray<int32> neighbors[NEIGHBOR_COUNT];
+	LinkTiles(worldTiles, neighbors);
+}
+
+void UTileGridSubsystem::LinkTiles(const TArray<AGameTile*>& TilesToLink, TArray<int32> (&OutNeighbors)[NEIGHBOR_COUNT])
+{
+	TArray<FVector> locations;
+	TArray<float> spacings, verticalRanges;
+	locations.Reserve(TilesToLink.Num());
+	spacings.Reserve(TilesToLink.Num());
+	verticalRanges.Reserve(TilesToLink.Num());
+	for (AGameTile* tile : TilesToLink)
+	{
+		locations.Add(tile->GetActorLocation());
+		spacings.Add(tile->AdjacentTileDistance);
+		verticalRanges.Add(tile->AdjacentTileVerticalRange);
+	}
+
+	FTileSpatialHashLinker::LinkTiles(locations, spacings, verticalRanges, OutNeighbors);
+
+	for (int32 tileIndex = 0; tileIndex < TilesToLink.Num(); tileIndex++)
+	{
+		AGameTile* tile = TilesToLink[tileIndex];
+		tile->NorthTile = OutNeighbors[NEIGHBOR_NORTH][tileIndex] != INDEX_NONE ? TilesToLink[OutNeighbors[NEIGHBOR_NORTH][tileIndex]] : nullptr;
+		tile->WestTile = OutNeighbors[NEIGHBOR_WEST][tileIndex] != INDEX_NONE ? TilesToLink[OutNeighbors[NEIGHBOR_WEST][tileIndex]] : nullptr;
+		tile->EastTile = OutNeighbors[NEIGHBOR_EAST][tileIndex] != INDEX_NONE ? TilesToLink[OutNeighbors[NEIGHBOR_EAST][tileIndex]] : nullptr;
+		tile->SouthTile = OutNeighbors[NEIGHBOR_SOUTH][tileIndex] != INDEX_NONE ? TilesToLink[OutNeighbors[NEIGHBOR_SOUTH][tileIndex]] : nullptr;
+		tile->bNeighborsLinked = true;	// missing neighbors are known to be empty - no runtime retrace
+	}
+}
+
+const FTileGridData& UTileGridSubsystem::GetGridData() const
+{
+	return GridData;
+}
+
+TSharedRef<const FTileGridData, ESPMode::ThreadSafe> UTileGridSubsystem::GetGridSnapshot()
+{
+	if (!GridSnapshot.IsValid() || GridSnapshotEpoch != WorldEpoch)
+	{
+		GridSnapshot = MakeShared<const FTileGridData, ESPMode::ThreadSafe>(GridData);	// searches still holding the old copy keep it alive
+		GridSnapshotEpoch = WorldEpoch;
+	}
+	return GridSnapshot.ToSharedRef();
+}
+
+int32 UTileGridSubsystem::GetTileCount() const
+{
+	return Tiles.Num();
+}
+
+AGameTile* UTileGridSubsystem::GetTile(int32 TileIndex) const
+{
+	AGameTile* tile = FindTile(TileIndex);
+	if (!tile && TileInstanceManager && Tiles.IsValidIndex(TileIndex))
+	{
+		tile = TileInstanceManager->GetTileFacade(TileIndex);
+	}
+	return tile;
+}
+
+AGameTile* UTileGridSubsystem::FindTile(int32 TileIndex) const
+{
+	return Tiles.IsValidIndex(TileIndex) ? Tiles[TileIndex] : nullptr;
+}
+
+void UTileGridSubsystem::RegisterTileFacade(int32 TileIndex, AGameTile* Tile)
+{
+	if (Tiles.IsValidIndex(TileIndex))
+	{
+		Tiles[TileIndex] = Tile;
+	}
+}
+
+int32 UTileGridSubsystem::GetTileIndex(const AGameTile* Tile) const
+{
+	if (!Tile || !Tiles.IsValidIndex(Tile->TileIndex) || Tiles[Tile->TileIndex] != Tile)
+	{
+		return INDEX_NONE;
+	}
+	return Tile->TileIndex;
+}
+
+int32 UTileGridSubsystem::GetNeighborIndex(int32 TileIndex, ETileNeighbor Direction) const
+{
+	if (!GridData.IsValidTile(TileIndex) || Direction >= NEIGHBOR_COUNT)
+	{
+		return INDEX_NONE;
+	}
+	return GridData.GetNeighbor(TileIndex, Direction);
+}
+
+AGameTile* UTileGridSubsystem::GetNeighborTile(const AGameTile* Tile, ETileNeighbor Direction) const
+{
+	return GetTile(GetNeighborIndex(GetTileIndex(Tile), Direction));
+}
+
+void UTileGridSubsystem::SetTileTerrainType(int32 TileIndex, uint8 TerrainType)
+{
+	if (GridData.IsValidTile(TileIndex) && GridData.TerrainTypes[TileIndex] != TerrainType)
+	{
+		GridData.TerrainTypes[TileIndex] = TerrainType;
+		TerrainEpoch++;	// every cached cost grid is rebuilt on its next use
+		BumpWorldEpoch();
+		OnTileChanged.Broadcast(TileIndex);
+
+		if (TileInstanceManager)
+		{
+			TileInstanceManager->SetInstanceTerrainType(TileIndex, TerrainType);
+		}
+	}
+}
+
+void UTileGridSubsystem::SetTileOccupant(int32 TileIndex, AGameUnit* Unit)
+{
+	if (!GridData.IsValidTile(TileIndex))
+	{
+		return;
+	}
+
+	TileOccupants[TileIndex] = Unit;
+	GridData.SetOccupantFaction(TileIndex, Unit ? Unit->UnitFaction : (uint8)EUnitFaction::NO_FACTION);
+	BumpWorldEpoch();	// units block movement and can be targeted - cached reachability is stale
+	OnTileChanged.Broadcast(TileIndex);
+}
+
+AGameUnit* UTileGridSubsystem::GetTileOccupant(int32 TileIndex) const
+{
+	return TileOccupants.IsValidIndex(TileIndex) ? TileOccupants[TileIndex] : nullptr;
+}
+
+void UTileGridSubsystem::GetUnitsInRange(int32 SourceTile, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<AGameUnit*>& OutUnits) const
+{
+	GridData.ForEachOccupiedTileInRange(SourceTile, MinRange, MaxRange, FactionMask, [this, &OutUnits](int32 TileIndex)
+		{
+			if (AGameUnit* unit = TileOccupants[TileIndex])
+			{
+				OutUnits.Add(unit);
+			}
+		});
+}
+
+void UTileGridSubsystem::GetUnitsInRangeOfTiles(TConstArrayView<int32> SourceTiles, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<AGameUnit*>& OutUnits) const
+{
+	TArray<int32> foundTiles;
+	GridData.FindOccupiedTilesInRange(SourceTiles, MinRange, MaxRange, FactionMask, foundTiles);
+	for (int32 tileIndex : foundTiles)
+	{
+		if (AGameUnit* unit = TileOccupants[tileIndex])
+		{
+			OutUnits.Add(unit);
+		}
+	}
+}
+
+void UTileGridSubsystem::ComputeReachability(const FTileReachabilityQuery& Query, FTileReachabilityResult& OutResult)
+{
+	ReachabilityEngine.Compute(GridData, Query, OutResult);
+}
+
+TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> UTileGridSubsystem::GetMoveCostGrid(const FMovementCostTable& CostTable)
+{
+	FTileCostGrid* costGrid = CostGrids.Find(CostTable.MoveCostHash);
+	if (!costGrid)
+	{
+		if (CostGrids.Num() >= 64)
+		{
+			// Tables recompiled at runtime leave old costs behind - drop the least recently used grid. Queries keep their own references.
+			uint32 oldestKey = 0;
+			uint64 oldestUse = MAX_uint64;
+			for (const TPair<uint32, FTileCostGrid>& entry : CostGrids)
+			{
+				if (entry.Value.LastUsed < oldestUse)
+				{
+					oldestUse = entry.Value.LastUsed;
+					oldestKey = entry.Key;
+				}
+			}
+			CostGrids.Remove(oldestKey);
+		}
+		costGrid = &CostGrids.Add(CostTable.MoveCostHash);
+	}
+	costGrid->LastUsed = ++CostGridUseCounter;
+
+	const bool bSameCosts = costGrid->Costs.IsValid() && FMemory::Memcmp(costGrid->MoveCosts, CostTable.MoveCosts, sizeof(CostTable.MoveCosts)) == 0;
+	if (!bSameCosts || costGrid->TerrainEpoch != TerrainEpoch || costGrid->Costs->Num() != GridData.Num())
+	{
+		const int32 tileCount = GridData.Num();
+		TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> newCosts = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		newCosts->SetNumUninitialized(tileCount);
+
+		const uint8* terrainTypes = GridData.TerrainTypes.GetData();
+		uint8* costs = newCosts->GetData();
+		for (int32 tileIndex = 0; tileIndex < tileCount; tileIndex++)
+		{
+			costs[tileIndex] = CostTable.MoveCosts[terrainTypes[tileIndex]];
+		}
+		costGrid->Costs = newCosts;	// searches still holding the old costs keep them alive
+		FMemory::Memcpy(costGrid->MoveCosts, CostTable.MoveCosts, sizeof(CostTable.MoveCosts));	// a hash collision just rebuilds for the newer table
+		costGrid->TerrainEpoch = TerrainEpoch;
+	}
+	return costGrid->Costs.ToSharedRef();
+}
+
+ETileNeighbor UTileGridSubsystem::CardinalToNeighbor(ECardinalDirections Direction)
+{
+	switch (Direction)
+	{
+	case (ECardinalDirections::UP_DIR):
+		return NEIGHBOR_NORTH;
+	case (ECardinalDirections::LEFT_DIR):
+		return NEIGHBOR_WEST;
+	case (ECardinalDirections::RIGHT_DIR):
+		return NEIGHBOR_EAST;
+	case (ECardinalDirections::DOWN_DIR):
+		return NEIGHBOR_SOUTH;
+	default:
+		return NEIGHBOR_COUNT;
+	}
+}
+
+ECardinalDirections UTileGridSubsystem::NeighborToCardinal(ETileNeighbor Direction)
+{
+	switch (Direction)
+	{
+	case (NEIGHBOR_NORTH):
+		return ECardinalDirections::UP_DIR;
+	case (NEIGHBOR_WEST):
+		return ECardinalDirections::LEFT_DIR;
+	case (NEIGHBOR_EAST):
+		return ECardinalDirections::RIGHT_DIR;
+	case (NEIGHBOR_SOUTH):
+		return ECardinalDirections::DOWN_DIR;
+	default:
+		return ECardinalDirections::NONE;
+	}
+}
@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileInstanceManager.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "EngineUtils.h"
+#include "Serialization/CustomVersion.h"
+#include "GameTile.h"
+#include "TileDataActor.h"
+#include "TileGridSubsystem.h"
+#include "TileOverlaySubsystem.h"
+
+#if WITH_EDITOR
+#include "ScopedTransaction.h"
+#endif
+
+// Custom version for the tile record block - maps saved before it existed skip reading it
+namespace TileInstanceVersion
+{
+	enum Type : int32
+	{
+		BeforeCustomVersion	= 0,
+		TileRecords			= 1,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	const FGuid GUID(0x2F8D4B61, 0x7C3A4E95, 0xB06E1A27, 0xD4C85F3B);
+}
+
+FCustomVersionRegistration GRegisterTileInstanceVersion(TileInstanceVersion::GUID, TileInstanceVersion::LatestVersion, TEXT("TileInstanceVersion"));
+
+// Sets default values
+ATileInstanceManager::ATileInstanceManager()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	TileInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("TileInstances"));
+	TileInstances->NumCustomDataFloats = TILE_CUSTOM_DATA_COUNT;
+	TileInstances->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	TileInstances->SetCollisionObjectType(ECC_WorldStatic);
+	TileInstances->SetCollisionResponseToAllChannels(ECR_Ignore);
+	TileInstances->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECR_Overlap);	// units find their starting tile with this channel
+	RootComponent = TileInstances;
+}
+
+// Called when the game starts or when spawned
+void ATileInstanceManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (auto* overlays = GetWorld()->GetSubsystem<UTileOverlaySubsystem>())
+	{
+		TileOverlaysChangedHandle = overlays->OnTileOverlaysChangedNative.AddUObject(this, &ATileInstanceManager::OnTileOverlaysChanged);
+	}
+}
+
+void ATileInstanceManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto* overlays = GetWorld()->GetSubsystem<UTileOverlaySubsystem>())
+	{
+		overlays->OnTileOverlaysChangedNative.Remove(TileOverlaysChangedHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATileInstanceManager::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	Ar.UsingCustomVersion(TileInstanceVersion::GUID);
+	if (Ar.CustomVer(TileInstanceVersion::GUID) >= TileInstanceVersion::TileRecords)
+	{
+		TileRecords.BulkSerialize(Ar);	// one contiguous block - loads without per-record work
+	}
+}
+
+void ATileInstanceManager::ConvertTilesToInstances()
+{
+	UWorld* world = GetWorld();
+	if (!world)
+	{
+		return;
+	}
+
+	// Index the map the same way the runtime does
+	TArray<AGameTile*> tiles;
+	FTileGridData gridData;
+	UTileGridSubsystem::BuildGridFromTiles(world, tiles, gridData);
+	if (tiles.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ConvertTilesToInstances: no tiles to convert"));
+		return;
+	}
+
+#if WITH_EDITOR
+	const FScopedTransaction transaction(NSLOCTEXT("TileInstanceManager", "ConvertTilesToInstances", "Convert Tiles To Instances"));	// one undo step restores the tile actors and clears the instances
+#endif
+
+	Modify();
+	TileInstances->Modify();
+	TileInstances->ClearInstances();
+	for (int32 tileIndex = 0; tileIndex < tiles.Num(); tileIndex++)
+	{
+		AGameTile* tile = tiles[tileIndex];
+		gridData.TerrainTypes[tileIndex] = tile->GetTerrainTypeByte();
+
+		TileInstances->AddInstance(tile->GetActorTransform(), true);
+		TileInstances->SetCustomDataValue(tileIndex, TILE_CUSTOM_DATA_TERRAIN, gridData.TerrainTypes[tileIndex]);
+		TileInstances->SetCustomDataValue(tileIndex, TILE_CUSTOM_DATA_OVERLAY, 0.0f);
+	}
+	TileInstances->MarkRenderStateDirty();
+	gridData.ExportRecords(TileRecords);
+
+	// Tiles the tile data actor points at stay in the level as facades so its references survive
+	ATileDataActor* tileData = nullptr;
+	for (TActorIterator<ATileDataActor> it(world); it; ++it)
+	{
+		tileData = *it;
+		break;
+	}
+
+	TMap<AGameTile*, AGameTile*> keptTiles;
+	if (tileData)
+	{
+		keptTiles.Add(tileData->StartingViewTile);
+		keptTiles.Add(tileData->StartingHoverTile);
+		for (AGameTile* tile : tileData->PlayerStartingTiles)
+		{
+			keptTiles.Add(tile);
+		}
+		keptTiles.Remove(nullptr);
+	}
+
+	PlacedFacadeTiles.Reset();
+	for (TPair<AGameTile*, AGameTile*>& keptTile : keptTiles)
+	{
+		AGameTile* facade = world->SpawnActor<AGameTile>(FacadeTileClass ? *FacadeTileClass : AGameTile::StaticClass(), keptTile.Key->GetActorTransform());
+		facade->TileIndex = keptTile.Key->TileIndex;
+		facade->bNeighborsLinked = true;
+		keptTile.Value = facade;
+		PlacedFacadeTiles.Add(facade);
+	}
+
+	if (tileData)
+	{
+		tileData->Modify();
+		tileData->StartingViewTile = keptTiles.FindRef(tileData->StartingViewTile);
+		tileData->StartingHoverTile = keptTiles.FindRef(tileData->StartingHoverTile);
+		for (AGameTile*& tile : tileData->PlayerStartingTiles)
+		{
+			tile = keptTiles.FindRef(tile);
+		}
+		tileData->BakedGraphTiles.Reset();		// the records here replace the baked tile graph
+		tileData->BakedGraphRecords.Reset();
+		tileData->BakedTileLayoutHash = 0;
+	}
+
+	for (AGameTile* tile : tiles)
+	{
+		tile->Modify();
+		tile->Destroy();
+	}
+}
+
+bool ATileInstanceManager::HasTileRecords() const
+{
+	return !TileRecords.IsEmpty() && TileRecords.Num() == TileInstances->GetInstanceCount();
+}
+
+AGameTile* ATileInstanceManager::GetTileFacade(int32 TileIndex)
+{
+	UTileGridSubsystem* tileGrid = GetTileGrid();
+	if (!tileGrid || TileIndex < 0 || TileIndex >= tileGrid->GetTileCount())
+	{
+		return nullptr;
+	}
+	if (AGameTile* tile = tileGrid->FindTile(TileIndex))
+	{
+		return tile;
+	}
+
+	FTransform transform;
+	if (!TileInstances->GetInstanceTransform(TileIndex, transform, true))
+	{
+		return nullptr;
+	}
+
+	// Deferred so the tile has its index and terrain before its BeginPlay runs
+	AGameTile* tile = GetWorld()->SpawnActorDeferred<AGameTile>(FacadeTileClass ? *FacadeTileClass : AGameTile::StaticClass(), transform);
+	tile->TileIndex = TileIndex;
+	tile->bNeighborsLinked = true;	// neighbors come from the tile grid - never traced
+	tileGrid->RegisterTileFacade(TileIndex, tile);
+	tile->SetTerrainType(tileGrid->GetGridData().TerrainTypes[TileIndex]);
+
+	if (auto* overlays = GetWorld()->GetSubsystem<UTileOverlaySubsystem>())
+	{
+		tile->SetOverlayFlags(overlays->GetTileOverlayFlags(TileIndex));
+	}
+
+	tile->FinishSpawning(transform);
+	return tile;
+}
+
+void ATileInstanceManager::SetInstanceTerrainType(int32 TileIndex, uint8 TerrainType)
+{
+	if (TileIndex >= 0 && TileIndex < TileInstances->GetInstanceCount())
+	{
+		TileInstances->SetCustomDataValue(TileIndex, TILE_CUSTOM_DATA_TERRAIN, TerrainType, true);
+	}
+}
+
+void ATileInstanceManager::OnTileOverlaysChanged(TConstArrayView<int32> TileIndices, TConstArrayView<uint8> TileFlags)
+{
+	const int32 instanceCount = TileInstances->GetInstanceCount();
+	for (int32 i = 0; i < TileIndices.Num(); i++)
+	{
+		if (TileIndices[i] < instanceCount)
+		{
+			TileInstances->SetCustomDataValue(TileIndices[i], TILE_CUSTOM_DATA_OVERLAY, TileFlags[i]);
+		}
+	}
+	TileInstances->MarkRenderStateDirty();	// one render update for the whole batch
+}
+
+UTileGridSubsystem* ATileInstanceManager::GetTileGrid() const
+{
+	UWorld* world = GetWorld();
+	return world ? world->GetSubsystem<UTileGridSubsystem>() : nullptr;
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileOverlaySubsystem.h"
+#include "GameTile.h"
+#include "TileGridSubsystem.h"
+
+void UTileOverlaySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TileGrid = InWorld.GetSubsystem<UTileGridSubsystem>();
+	PrepareTileArrays();
+}
+
+void UTileOverlaySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (DirtyTiles.Num() > 0)
+	{
+		FlushTileOverlayChanges();
+	}
+}
+
+TStatId UTileOverlaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTileOverlaySubsystem, STATGROUP_Tickables);
+}
+
+void UTileOverlaySubsystem::PrepareTileArrays()
+{
+	const int32 tileCount = TileGrid ? TileGrid->GetTileCount() : 0;
+	if (TileFlags.Num() != tileCount)
+	{
+		TileFlags.Init(OVERLAY_NONE, tileCount);
+		BroadcastFlags.Init(OVERLAY_NONE, tileCount);
+		DirtyTileSet.Init(tileCount);
+		DirtyTiles.Reset();
+	}
+}
+
+void UTileOverlaySubsystem::SetTileOverlayFlag(int32 TileIndex, ETileOverlayFlags Flag, bool Toggle)
+{
+	PrepareTileArrays();
+	if (!TileFlags.IsValidIndex(TileIndex))
+	{
+		return;
+	}
+
+	const uint8 newFlags = Toggle ? (TileFlags[TileIndex] | Flag) : (TileFlags[TileIndex] & ~Flag);
+	if (newFlags == TileFlags[TileIndex])
+	{
+		return;
+	}
+
+	TileFlags[TileIndex] = newFlags;
+	if (AGameTile* tile = TileGrid->FindTile(TileIndex))
+	{
+		tile->SetOverlayFlags(newFlags);	// gameplay reads the tile state right away, only the events wait for the flush. Instanced tiles without an actor pick the flags up when their facade spawns.
+	}
+
+	if (!DirtyTileSet.Contains(TileIndex))
+	{
+		DirtyTileSet.Add(TileIndex);
+		DirtyTiles.Add(TileIndex);
+	}
+}
+
+uint8 UTileOverlaySubsystem::GetTileOverlayFlags(int32 TileIndex) const
+{
+	return TileFlags.IsValidIndex(TileIndex) ? TileFlags[TileIndex] : (uint8)OVERLAY_NONE;
+}
+
+void UTileOverlaySubsystem::FlushTileOverlayChanges()
+{
+	ChangedTileIndices.Reset();
+	ChangedTileFlags.Reset();
+
+	for (int32 tileIndex : DirtyTiles)
+	{
+		DirtyTileSet.Remove(tileIndex);
+
+		const uint8 oldFlags = BroadcastFlags[tileIndex];
+		const uint8 newFlags = TileFlags[tileIndex];
+		if (oldFlags == newFlags)
+		{
+			continue;	// set and cleared again within the frame
+		}
+		BroadcastFlags[tileIndex] = newFlags;
+
+		ChangedTileIndices.Add(tileIndex);
+		ChangedTileFlags.Add(newFlags);
+
+		AGameTile* tile = TileGrid->FindTile(tileIndex);
+		if (tile && tile->bUsePerTileOverlayEvents)
+		{
+			tile->BroadcastOverlayChange(oldFlags, newFlags);
+		}
+	}
+	DirtyTiles.Reset();
+
+	if (ChangedTileIndices.Num() == 0)
+	{
+		return;
+	}
+
+	OnTileOverlaysChangedNative.Broadcast(ChangedTileIndices, ChangedTileFlags);
+	OnTileOverlaysChanged.Broadcast(ChangedTileIndices, ChangedTileFlags);
+}
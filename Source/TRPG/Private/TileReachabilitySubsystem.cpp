@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileReachabilitySubsystem.h"
+#include "GameUnit.h"
+#include "TileGridSubsystem.h"
+#include "MovementClassAsset.h"
+#include "Async/ParallelFor.h"
+
+void UTileReachabilitySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TileGrid = Collection.InitializeDependency<UTileGridSubsystem>();
+}
+
+void FCachedReachability::BuildTileSets(int32 TileCount)
+{
+	NavigableTiles.Init(TileCount);
+	AttackableTiles.Init(TileCount);
+	InteractableTiles.Init(TileCount);
+	for (int32 tileIndex : Result.NavigableTiles)
+	{
+		NavigableTiles.Add(tileIndex);
+	}
+	for (int32 tileIndex : Result.AttackableTiles)
+	{
+		AttackableTiles.Add(tileIndex);
+	}
+	for (int32 tileIndex : Result.InteractableTiles)
+	{
+		InteractableTiles.Add(tileIndex);
+	}
+
+	AllocatedBytes = Result.NavigableTiles.GetAllocatedSize() + Result.Distances.GetAllocatedSize() + Result.Predecessors.GetAllocatedSize()
+		+ Result.AttackableTiles.GetAllocatedSize() + Result.InteractableTiles.GetAllocatedSize() + Result.TileSlots.GetAllocatedSize()
+		+ 3 * NavigableTiles.GetWords().Num() * sizeof(uint64);
+}
+
+void FTileReachabilityJob::Run(const FTileGridData& Grid, FTileReachabilityEngine& Engine)
+{
+	Query.MoveCosts = MoveCosts;	// point at the owned copies - the job may have moved since it was built
+	Query.TileCosts = Query.TileCostsOwner.IsValid() ? TConstArrayView<uint8>(*Query.TileCostsOwner) : TConstArrayView<uint8>();
+
+	Engine.Compute(Grid, Query, Entry.Result);
+	Entry.BuildTileSets(Grid.Num());
+}
+
+const FCachedReachability& UTileReachabilitySubsystem::GetReachability(const AGameUnit* Unit, const FTileReachabilityQuery& Query, uint32 CostTableVersion)
+{
+	SyncWorldEpoch();
+
+	const FTileReachabilityCacheKey key = MakeCacheKey(Unit, Query, CostTableVersion);
+	CollectPendingJobs(&key);	// a prefetch already under way finishes sooner than a new search
+	if (FCachedReachability* cached = Entries.Find(key))
+	{
+		cached->LastUsed = ++UseCounter;
+		return *cached;
+	}
+
+	FCachedReachability entry;
+	TileGrid->ComputeReachability(Query, entry.Result);
+	entry.BuildTileSets(TileGrid->GetTileCount());
+	return AddEntry(key, MoveTemp(entry));
+}
+
+void UTileReachabilitySubsystem::PrecomputeReachability(TConstArrayView<AGameUnit*> Units)
+{
+	if (!TileGrid)
+	{
+		return;
+	}
+	SyncWorldEpoch();
+
+	// Queries are built on the game thread - weapon ranges come from blueprint
+	TArray<FTileReachabilityJob> jobs;
+	jobs.Reserve(Units.Num());
+	for (AGameUnit* unit : Units)
+	{
+		const int32 startIndex = IsValid(unit) ? TileGrid->GetTileIndex(unit->GetCurrentUnitTile()) : INDEX_NONE;
+		if (startIndex == INDEX_NONE || jobs.Num() >= MaxEntries)
+		{
+			continue;	// off the grid, or more units than the cache keeps
+		}
+
+		FTileReachabilityQuery query;
+		unit->MakeSelectionQuery(*TileGrid, startIndex, query);
+
+		const FMovementCostTable* costTable = unit->GetUnitCostTable();
+		const FTileReachabilityCacheKey key = MakeCacheKey(unit, query, costTable ? costTable->Version : 0);
+		if (FCachedReachability* cached = Entries.Find(key))
+		{
+			cached->LastUsed = ++UseCounter;
+			continue;
+		}
+		MakeJob(unit, query, key.CostTableVersion, jobs.AddDefaulted_GetRef());
+	}
+	if (jobs.IsEmpty())
+	{
+		return;
+	}
+
+	// Each task gets its own engine - the scratch arrays are the only mutable state a search has
+	const TSharedRef<const FTileGridData, ESPMode::ThreadSafe> gridSnapshot = TileGrid->GetGridSnapshot();
+	TArray<FTileReachabilityEngine> engines;
+	ParallelForWithTaskContext(engines, jobs.Num(), [&jobs, &gridSnapshot](FTileReachabilityEngine& Engine, int32 JobIndex)
+		{
+			jobs[JobIndex].Run(*gridSnapshot, Engine);
+		});
+
+	for (FTileReachabilityJob& job : jobs)
+	{
+		AddJobResult(job);
+	}
+}
+
+void UTileReachabilitySubsystem::PrefetchReachability(AGameUnit* Unit, int32 StartTile)
+{
+	if (!TileGrid || !IsValid(Unit) || StartTile == INDEX_NONE)
+	{
+		return;
+	}
+	SyncWorldEpoch();
+	CollectPendingJobs();
+
+	FTileReachabilityQuery query;
+	Unit->MakeSelectionQuery(*TileGrid, StartTile, query);
+
+	const FMovementCostTable* costTable = Unit->GetUnitCostTable();
+	const FTileReachabilityCacheKey key = MakeCacheKey(Unit, query, costTable ? costTable->Version : 0);
+	if (Entries.Contains(key) || PendingJobs.Num() >= MaxPendingJobs
+		|| PendingJobs.ContainsByPredicate([&key](const FPendingReachabilityJob& Pending) { return Pending.Job->Key == key; }))
+	{
+		return;
+	}
+
+	FPendingReachabilityJob& pending = PendingJobs.AddDefaulted_GetRef();
+	pending.Job = MakeShared<FTileReachabilityJob, ESPMode::ThreadSafe>();
+	MakeJob(Unit, query, key.CostTableVersion, *pending.Job);
+
+	// The task only reads its own copies - the game thread can keep changing the grid while it runs
+	pending.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [job = pending.Job, gridSnapshot = TileGrid->GetGridSnapshot()]()
+		{
+			FTileReachabilityEngine engine;
+			job->Run(*gridSnapshot, engine);
+		});
+}
+
+void UTileReachabilitySubsystem::MakeJob(const AGameUnit* Unit, const FTileReachabilityQuery& Query, uint32 CostTableVersion, FTileReachabilityJob& OutJob) const
+{
+	OutJob.Key = MakeCacheKey(Unit, Query, CostTableVersion);
+	OutJob.Query = Query;
+	OutJob.MoveCosts = TArray<uint8>(Query.MoveCosts.GetData(), Query.MoveCosts.Num());
+	if (!Query.TileCostsOwner.IsValid() && Query.TileCosts.Num())
+	{
+		OutJob.Query.SetTileCosts(MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(Query.TileCosts.GetData(), Query.TileCosts.Num()));	// not shared storage - own a copy
+	}
+	OutJob.WorldEpoch = TileGrid ? TileGrid->GetWorldEpoch() : 0;
+}
+
+bool UTileReachabilitySubsystem::AddJobResult(FTileReachabilityJob& Job)
+{
+	if (!TileGrid || Job.WorldEpoch != TileGrid->GetWorldEpoch())
+	{
+		return false;	// searched on a map that no longer exists
+	}
+
+	SyncWorldEpoch();
+	AddEntry(Job.Key, MoveTemp(Job.Entry));
+	return true;
+}
+
+FTileReachabilityCacheKey UTileReachabilitySubsystem::MakeCacheKey(const AGameUnit* Unit, const FTileReachabilityQuery& Query, uint32 CostTableVersion)
+{
+	FTileReachabilityCacheKey key;
+	key.Unit = Unit;
+	key.StartTile = Query.StartTile;
+	key.MoveBudget = Query.MoveBudget;
+	key.CostTableVersion = CostTableVersion;
+	key.HostileFactions = Query.HostileFactions;
+	key.AlliedFactions = Query.AlliedFactions;
+	key.MinActRange = Query.MinActRange;
+	key.MaxActRange = Query.MaxActRange;
+	key.bTargetsEnemies = Query.bTargetsEnemies;
+	key.bTargetsAllies = Query.bTargetsAllies;
+	return key;
+}
+
+void UTileReachabilitySubsystem::SyncWorldEpoch()
+{
+	if (CachedWorldEpoch != TileGrid->GetWorldEpoch())
+	{
+		ClearCache();	// something moved or changed on the map - every result may be different now
+		CachedWorldEpoch = TileGrid->GetWorldEpoch();
+	}
+}
+
+FCachedReachability& UTileReachabilitySubsystem::AddEntry(const FTileReachabilityCacheKey& Key, FCachedReachability&& Entry)
+{
+	if (const FCachedReachability* existing = Entries.Find(Key))
+	{
+		CachedBytes -= existing->AllocatedBytes;
+	}
+
+	FCachedReachability& entry = Entries.Add(Key, MoveTemp(Entry));
+	entry.LastUsed = ++UseCounter;
+	CachedBytes += entry.AllocatedBytes;
+
+	EvictToBudget(Key);
+	return *Entries.Find(Key);	// eviction may have moved the entry
+}
+
+void UTileReachabilitySubsystem::ClearCache()
+{
+	Entries.Reset();
+	PendingJobs.Reset();	// running tasks finish on their own references and are ignored
+	CachedBytes = 0;
+}
+
+void UTileReachabilitySubsystem::CollectPendingJobs(const FTileReachabilityCacheKey* WaitKey)
+{
+	for (int32 pendingIndex = PendingJobs.Num() - 1; pendingIndex >= 0; pendingIndex--)
+	{
+		FPendingReachabilityJob& pending = PendingJobs[pendingIndex];
+		if (pending.Job->WorldEpoch != TileGrid->GetWorldEpoch())
+		{
+			PendingJobs.RemoveAtSwap(pendingIndex);	// searched a map that has changed since - the result is never used
+			continue;
+		}
+
+		if (WaitKey && pending.Job->Key == *WaitKey)
+		{
+			pending.Task.Wait();
+		}
+		if (pending.Task.IsCompleted())
+		{
+			AddJobResult(*pending.Job);
+			PendingJobs.RemoveAtSwap(pendingIndex);
+		}
+	}
+}
+
+void UTileReachabilitySubsystem::EvictToBudget(const FTileReachabilityCacheKey& KeepKey)
+{
+	while (Entries.Num() > 1 && (Entries.Num() > MaxEntries || CachedBytes > MaxCachedBytes))
+	{
+		// Few entries - a scan for the oldest is cheaper than keeping a linked list in order
+		const FTileReachabilityCacheKey* oldestKey = nullptr;
+		uint64 oldestUse = MAX_uint64;
+		for (const TPair<FTileReachabilityCacheKey, FCachedReachability>& entry : Entries)
+		{
+			if (entry.Value.LastUsed < oldestUse && !(entry.Key == KeepKey))
+			{
+				oldestUse = entry.Value.LastUsed;
+				oldestKey = &entry.Key;
+			}
+		}
+		if (!oldestKey)
+		{
+			return;
+		}
+
+		const FTileReachabilityCacheKey evictedKey = *oldestKey;
+		CachedBytes -= Entries[evictedKey].AllocatedBytes;
+		Entries.Remove(evictedKey);
+	}
+}
@@ -19,7 +19,10 @@ void UUnitMovementData::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
+	if (MovementClass)
+	{
+		SetMovementClass(MovementClass);
+	}
 	
 }
 
@@ -34,24 +37,37 @@ void UUnitMovementData::TickComponent(float DeltaTime, ELevelTick TickType, FAct
 
 void UUnitMovementData::SetMovementMap(TMap<uint8, FTerrainInfo> NewTerrainData)
 {
+	if (MovementClass)
+	{
+		return;	// the movement class already provides the data
+	}
+
 	MoveCostMap = NewTerrainData;
+	OwnCostTable.Compile(MoveCostMap);
+	CostTable = &OwnCostTable;
 }
 
-uint8 UUnitMovementData::GetMoveCostInfo(uint8 TileType)
+void UUnitMovementData::SetMovementClass(UMovementClassAsset* NewMovementClass)
 {
-	if (MoveCostMap.Contains(TileType))
-	{
-		return MoveCostMap[TileType].MoveCost;	// found the move cost
-	}
+	MovementClass = NewMovementClass;
+	CostTable = MovementClass ? &MovementClass->GetCostTable() : &OwnCostTable;
+}
 
-	return 255;	// missing data from map
+TConstArrayView<uint8> UUnitMovementData::GetMoveCostTable() const
+{
+	return CostTable->GetMoveCosts();
 }
 
 FTerrainInfo UUnitMovementData::GetTerrainPassingInfo(uint8 TileType)
 {
-	if (MoveCostMap.Contains(TileType))
+	if (MovementClass)
+	{
+		return MovementClass->GetTerrainInfo(TileType);
+	}
+
+	if (const FTerrainInfo* info = MoveCostMap.Find(TileType))
 	{
-		return MoveCostMap[TileType];	// found the terrain data
+		return *info;	// found the terrain data
 	}
 
 	return FTerrainInfo();	// missing data from map
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UnitRegistrySubsystem.h"
+#include "TileGridSubsystem.h"
+
+void UUnitRegistrySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const int32 lastUpdate = FMath::Min(QueuedCosmeticsStart + MaxCosmeticUpdatesPerFrame, QueuedCosmetics.Num());
+	for (; QueuedCosmeticsStart < lastUpdate; QueuedCosmeticsStart++)
+	{
+		const FQueuedUnitCosmetics& queued = QueuedCosmetics[QueuedCosmeticsStart];
+		if (AGameUnit* unit = queued.Unit.Get())
+		{
+			unit->ApplyActivationCosmetics(queued.bActivated);
+		}
+	}
+
+	if (QueuedCosmeticsStart >= QueuedCosmetics.Num())
+	{
+		QueuedCosmetics.Reset();
+		QueuedCosmeticsStart = 0;
+	}
+}
+
+TStatId UUnitRegistrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UUnitRegistrySubsystem, STATGROUP_Tickables);
+}
+
+void UUnitRegistrySubsystem::RegisterUnit(AGameUnit* Unit)
+{
+	if (!Unit || Unit->RegistrySlot != INDEX_NONE)
+	{
+		return;
+	}
+	if (Unit->UnitFaction >= UNIT_FACTION_COUNT)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Unit %s has an unknown faction %d - not registered"), *Unit->GetName(), Unit->UnitFaction);
+		return;
+	}
+
+	TArray<AGameUnit*>& units = FactionUnits[Unit->UnitFaction];
+	Unit->RegistrySlot = units.Add(Unit);
+	Unit->RegisteredFaction = Unit->UnitFaction;
+}
+
+void UUnitRegistrySubsystem::UnregisterUnit(AGameUnit* Unit)
+{
+	if (!Unit || Unit->RegistrySlot == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Swap the last unit of the faction into the freed slot
+	TArray<AGameUnit*>& units = FactionUnits[Unit->RegisteredFaction];
+	const int32 slot = Unit->RegistrySlot;
+	units.RemoveAtSwap(slot, 1, EAllowShrinking::No);
+	if (units.IsValidIndex(slot))
+	{
+		units[slot]->RegistrySlot = slot;
+	}
+	Unit->RegistrySlot = INDEX_NONE;
+}
+
+void UUnitRegistrySubsystem::SetUnitFaction(AGameUnit* Unit, uint8 NewFaction)
+{
+	if (!Unit || Unit->UnitFaction == NewFaction)
+	{
+		return;
+	}
+
+	const bool bWasRegistered = Unit->RegistrySlot != INDEX_NONE;
+	UnregisterUnit(Unit);
+	Unit->UnitFaction = NewFaction;
+	if (bWasRegistered)
+	{
+		RegisterUnit(Unit);
+	}
+
+	// The tile grid keeps the faction of each tile's occupant for range searches
+	auto* tileGrid = GetWorld()->GetSubsystem<UTileGridSubsystem>();
+	const int32 tileIndex = tileGrid ? tileGrid->GetTileIndex(Unit->GetCurrentUnitTile()) : INDEX_NONE;
+	if (tileIndex != INDEX_NONE && tileGrid->GetTileOccupant(tileIndex) == Unit)
+	{
+		tileGrid->SetTileOccupant(tileIndex, Unit);
+	}
+}
+
+const TArray<AGameUnit*>& UUnitRegistrySubsystem::GetFactionUnits(uint8 Faction) const
+{
+	static const TArray<AGameUnit*> NoUnits;
+	return Faction < UNIT_FACTION_COUNT ? FactionUnits[Faction] : NoUnits;
+}
+
+void UUnitRegistrySubsystem::QueueActivationCosmetics(TConstArrayView<AGameUnit*> Units, bool bActivated)
+{
+	QueuedCosmetics.Reserve(QueuedCosmetics.Num() + Units.Num());
+	for (AGameUnit* unit : Units)
+	{
+		QueuedCosmetics.Add({ unit, bActivated });
+	}
+}
+
+void UUnitRegistrySubsystem::FlushActivationCosmetics()
+{
+	// Tick may run again from a blueprint handler - take the queue first
+	TArray<FQueuedUnitCosmetics> queued = MoveTemp(QueuedCosmetics);
+	const int32 firstUpdate = QueuedCosmeticsStart;
+	QueuedCosmetics.Reset();
+	QueuedCosmeticsStart = 0;
+
+	for (int32 updateIndex = firstUpdate; updateIndex < queued.Num(); updateIndex++)
+	{
+		if (AGameUnit* unit = queued[updateIndex].Unit.Get())
+		{
+			unit->ApplyActivationCosmetics(queued[updateIndex].bActivated);
+		}
+	}
+}
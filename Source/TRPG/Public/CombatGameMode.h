@@ -7,6 +7,7 @@
 #include "GameTile.h"
 #include "GameUnit.h"
 #include "CombatEvent.h"
+#include "BattleHistory.h"
 #include "GameFramework/GameModeBase.h"
 #include "CombatGameMode.generated.h"
 
@@ -33,6 +34,7 @@ enum ECombatPhase : uint8
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FTriggerPhase, ECombatPhase, NewPhase, ECombatPhase, PreviousPhase, uint8, TurnNumber);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FPausePhase, bool, ToggledPause);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FFactionActivation, uint8, Faction, bool, Toggle, const TArray<AGameUnit*>&, Units);
 
 // Combat game mode for phase-based gameplay.
 UCLASS()
@@ -52,6 +54,18 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Phases")
 	FPausePhase OnPausePhase;						// Fires when the phase is paused for an event
 
+	UPROPERTY(BlueprintAssignable, Category = "Phases")
+	FFactionActivation OnFactionActivation;			// Fires once per faction activated/deactivated by a phase change, with all of its units
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool bFastForward = false;						// Also set by -TRPGFastForward. Movement snaps, events run without waiting and phase transitions advance without waiting for visuals.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Phases")
+	bool bBatchPhaseActivation = true;				// When true, phase changes reset units natively and spread their per-unit activation visuals over the next frames
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "History")
+	bool bRecordBattleHistory = true;				// When true, the battle is snapshot at the start of each unit phase and after every action so it can be rewound
+
 protected:
 
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Phases")
@@ -66,6 +80,31 @@ protected:
 	ACombatEvent* CurrentEvent;				// Event keeping the phase loop paused
 	ECombatPhase QueuedPhaseAfterEvent;		// Phase to transition to after the event(s) are completed
 
+	UPROPERTY()
+	ATileControlPawn* ControlPawn;			// Control pawn found by the first GetControlPawn() call
+
+	// Fast-forward statistics
+
+	double			SimStartTime	= 0.0;			// Platform time the battle started
+	int32			SimPhaseCount	= 0;			// Unit phases run
+	int32			SimRoundCount	= 0;			// Times the phase order wrapped back to its first unit phase
+	ECombatPhase	LastUnitPhase	= ECombatPhase::NO_PHASE;
+
+	// Turn rewind
+
+	FBattleHistory	BattleHistory;				// Copy-on-write snapshots of the battle - unchanged pages are shared between them
+
+	FBattleState	HistoryState;				// State of the last snapshot taken or restored. Captures reuse its tile graph.
+
+	UPROPERTY()
+	TArray<AGameUnit*> HistoryUnits;			// Actor of each unit index in the history. Units keep their index for the whole battle.
+
+	uint32			HistoryTerrainEpoch		= 0;		// UTileGridSubsystem terrain epoch the history's terrain was taken at
+
+	FTimerHandle	BattleSnapshotTimer;				// Pending QueueBattleSnapshot() recording
+	bool			bBattleSnapshotQueued	= false;
+	bool			bApplyingBattleState	= false;	// Set while ApplyBattleState() hands units their restored actions
+
 public:
 	virtual void BeginFirstPhase();			// Triggers the before-combat phase once the player controller successfully binds to listen to phase change events
 
@@ -82,6 +121,31 @@ public:
 	UFUNCTION(BlueprintCallable)
 	ATileControlPawn* GetControlPawn();		// Gets the control pawn
 
+	// Copies the battle into a plain FBattleState - tiles, units and the active faction. InOutUnitActors[i] is the actor of unit i.
+	// Actors already in InOutUnitActors keep their index - as removed units once they left the battle - and new units are appended.
+	// A state already on this map keeps its tile graph and terrain, so only the units and cost tables are copied.
+	// Weapon ranges are asked from blueprint, so this runs on the game thread; the state can then be copied and stepped anywhere.
+	void CaptureBattleState(FBattleState& OutState, TArray<AGameUnit*>& InOutUnitActors);
+
+	// Moves the unit actors to match a battle state and sets the remaining movement and actions of the active faction's units
+	void ApplyBattleState(const FBattleState& State, const TArray<AGameUnit*>& UnitActors);
+
+	UFUNCTION(BlueprintCallable, Category = "History")
+	int32 RecordBattleSnapshot();			// Adds a snapshot of the battle to the history and returns its index. INDEX_NONE when not recording.
+
+	void QueueBattleSnapshot();				// Records a snapshot on the next tick. Called by AGameUnit whenever a unit of any faction spends an action.
+
+	// Returns the battle to a snapshot: units move back, get their movement and actions back and, for a snapshot of an earlier phase,
+	// that phase is made current again without its events. Snapshots after it are dropped. Defeated unit actors are not brought back.
+	UFUNCTION(BlueprintCallable, Category = "History")
+	bool RewindToSnapshot(int32 SnapshotIndex);
+
+	UFUNCTION(BlueprintPure, Category = "History")
+	int32 GetBattleSnapshotCount() const { return BattleHistory.Num(); }
+
+	UFUNCTION(BlueprintPure, Category = "Simulation", meta = (WorldContext = "WorldContextObject"))
+	static bool IsFastForwardBattle(const UObject* WorldContextObject);	// True when the current combat game mode runs in fast-forward
+
 protected:
 
 	virtual bool LinkToEventDataActor();	// Links to the event data actor. Every phase change requires an event check. 
@@ -91,8 +155,25 @@ protected:
 
 	virtual void PrepareUnitsOnPhaseShift(ECombatPhase NewPhase, ECombatPhase PreviousPhase);	// Updates unit states for the new phase.
 
-	// Counts the number of units for each faction. 
+	virtual void SetFactionActive(uint8 Faction, bool bActive, const TArray<AGameUnit*>& Units);	// Activates or deactivates every unit of a faction for a phase change
+
+	static uint8 GetPhaseFaction(ECombatPhase Phase);	// Faction whose units act in a phase. NO_FACTION for phases without units.
+
+	static ECombatPhase GetFactionPhase(uint8 Faction);	// Phase in which a faction's units act. NO_PHASE for NO_FACTION.
+
+	virtual void PrecomputeUnitReachability(const TArray<AGameUnit*>& Units);	// Searches the movement and attack tiles of the activated units on worker threads, ready for their first selection.
+
+	// Counts the number of units for each faction from the unit registry.
 	virtual void CountUnitsByAllegiance(uint8& PlayerUnitCount, uint8& PartnerUnitCount, uint8& EnemyUnitCount, uint8& NpcUnitCount); // Returns the unit counts for each unit allegiance.
 
 	virtual void ActivateCombatPhase(ECombatPhase CombatPhase);
+
+	// Plays a player phase of a fast-forward battle, where nobody gives input. By default the player units hold and the phase ends
+	// on the next tick - override it to let an AI act for the player units and call BeginNextCombatPhase when they are done.
+	UFUNCTION(BlueprintNativeEvent, Category = "Simulation")
+	void DriveFastForwardPlayerPhase();
+
+	void RecordQueuedBattleSnapshot();
+
+	virtual void ReportSimulationStats();	// Logs the battle outcome and phase rate. Called when a fast-forward battle ends.
 };
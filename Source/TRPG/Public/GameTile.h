@@ -81,6 +81,17 @@ enum ECardinalDirections : uint8
 	DOWN_DIR	= 4		UMETA(DisplayName = "DOWN")
 };
 
+// Highlight state of a tile while a unit is selected. Combined as bit flags.
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum ETileOverlayFlags : uint8
+{
+	OVERLAY_NONE			= 0		UMETA(Hidden),
+	OVERLAY_NAVIGABLE		= 1		UMETA(DisplayName = "Navigable"),
+	OVERLAY_ATTACKABLE		= 2		UMETA(DisplayName = "Attackable"),
+	OVERLAY_INTERACTABLE	= 4		UMETA(DisplayName = "Interactable"),
+	OVERLAY_THREATENED		= 8		UMETA(DisplayName = "Threatened")	// In range of an enemy - shown by the threat map display
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FTileHovered);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FTileUnhovered);
 
@@ -180,6 +191,15 @@ public:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
 	AGameTile* SouthTile;		//  Y axis - set by InitializeLinkToNeighbors()
 
+	UPROPERTY(VisibleAnywhere)
+	bool bNeighborsLinked = false;	// True once the neighbor links are set. Missing neighbors are then known to be empty and are not traced for again.
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	int32 TileIndex = INDEX_NONE;	// Index of this tile in the UTileGridSubsystem - set on map load
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Tile")
+	bool bUsePerTileOverlayEvents = false;	// Compatibility mode - also fire OnTileSetNavigable/OnTileUnsetNavigable etc. on this tile when the UTileOverlaySubsystem flushes. Off by default; bind to UTileOverlaySubsystem::OnTileOverlaysChanged instead.
+
 protected:
 
 	UPROPERTY(VisibleAnywhere)
@@ -224,6 +244,12 @@ public:
 
 	virtual void TriggerTileInteractable(bool Toggle);	// Called by tilecontrolpawn when this tile can be interacted (ally-targeting weapons)
 
+	uint8 GetOverlayFlags() const;				// ETileOverlayFlags this tile currently displays
+
+	void SetOverlayFlags(uint8 Flags);			// Sets IsNavigable/IsAttackable/IsInteractable without firing events - called by the UTileOverlaySubsystem
+
+	void BroadcastOverlayChange(uint8 OldFlags, uint8 NewFlags);	// Fires the per-tile set/unset events for each flag that changed
+
 	virtual void TriggerTilePathing(bool Toggle, ECardinalDirections PastTileDirection, ECardinalDirections NextTileDirection);	// Called by PlayerPathControl when setting path tile visibility
 
 	// Terrain data
@@ -239,8 +265,16 @@ public:
 	UFUNCTION(BlueprintImplementableEvent)
 	uint8 GetTerrainTypeByte();
 
+	UFUNCTION(BlueprintPure, Category = "Tile")
+	FTerrainInfo GetCachedTerrainInfoForHud();	// GetTerrainInfoForHud memoized by terrain type - use this from the HUD
+
+	UFUNCTION(BlueprintPure, Category = "Tile")
+	FTerrainInfo GetCachedTerrainInfoForUnit(const uint8 UnitMovementTypeInBytes);	// GetTerrainInfoForUnit memoized by terrain and movement type
+
 	static const uint8 GetTerrainTypeAsByte(AGameTile* Tile);
 
+	void SetTerrainType(uint8 NewTerrainTypeByte);	// Sets the terrain type byte and reports it to the tile grid
+
 	// Sets the unit to this tile
 	UFUNCTION()
 	virtual void SetUnitOnTile(AGameUnit* Unit, ECardinalDirections Direction);
@@ -261,7 +295,7 @@ public:
 
 protected:
 
-	// Traces for neighboring tiles and assigns them to NorthTile/WestTile/EastTile/SouthTile
+	// Finds neighboring tiles with the spatial hash linker and assigns them to NorthTile/WestTile/EastTile/SouthTile
 	virtual void InitializeLinkToNeighbors();
 
 
@@ -8,6 +8,9 @@
 
 class AGameTile;
 class UUnitMovementData;
+struct FMovementCostTable;
+struct FTileReachabilityQuery;
+class UTileGridSubsystem;
 enum ECardinalDirections : uint8;
 
 
@@ -22,6 +25,8 @@ enum EUnitFaction : uint8
 
 };
 
+#define UNIT_FACTION_COUNT 5	// Number of EUnitFaction values
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FUnitActivation, bool, Toggle);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTraveledToTile, AGameTile*, Tile);
@@ -34,6 +39,8 @@ UCLASS(Blueprintable)
 class TRPG_API AGameUnit : public APawn
 {
 	GENERATED_BODY()
+
+	friend class UUnitRegistrySubsystem;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -43,6 +50,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -59,7 +68,7 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Tile")
 	FUnitConfirmOnTile OnUnitConfirmOnTile;					
 
-	// 0 = no faction | 1 = player | 2 = ally | 3 = enemy | 4 = npc
+	// 0 = no faction | 1 = player | 2 = ally | 3 = enemy | 4 = npc. Change it with SetUnitFaction() during play so the unit registry follows.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	uint8 UnitFaction = EUnitFaction::NO_FACTION;
 
@@ -71,6 +80,15 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	bool GenerateStatsOnSave = false;			// When true, unit stats are auto-generated on-save
 
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	uint8 BaseMovementSpaces = 0;				// Spaces the unit can move at the start of a turn. Used for threat ranges. Left at 0, it is read from the Blueprint turn reset.
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	uint8 BaseActions = 1;						// Actions the unit can take at the start of a turn
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	bool bResetTurnNatively = false;			// When true, the turn reset copies BaseMovementSpaces/BaseActions instead of calling ResetUnitMovementAndActions
+
 protected:
 
 	AGameTile* CurrentUnitTile;				// The current unit's tile
@@ -83,6 +101,10 @@ protected:
 
 	UUnitMovementData* MovementDataComponent;	// Movement data component that initializes in blueprints
 
+	int32 RegistrySlot = INDEX_NONE;		// Position in the unit registry's array for RegisteredFaction. INDEX_NONE when not registered.
+
+	uint8 RegisteredFaction = EUnitFaction::NO_FACTION;	// Faction array the unit is registered in
+
 public:
 
 	// Unit main events
@@ -90,6 +112,13 @@ public:
 
 	virtual void DeactivateUnitOnPhaseEnd();				// Called by the combat game mode. Disables control over this unit.
 
+	void ResetUnitTurnState();								// Restores movement and actions for a new turn - natively, or through blueprint unless bResetTurnNatively is set
+
+	void ApplyActivationCosmetics(bool bActivated);			// Broadcasts OnUnitActivation and removes grayscale on deactivation. Deferred by batched phase activation.
+
+	UFUNCTION(BlueprintCallable)
+	void SetUnitFaction(uint8 NewFaction);					// Changes the unit's faction in the unit registry and on its tile
+
 	UFUNCTION(BlueprintCallable)
 	virtual void SetUnitLocAndRot(AGameTile* TargetTile, ECardinalDirections TargetDirection);	// Sets the unit on a specific tile
 
@@ -131,9 +160,22 @@ public:
 	UFUNCTION(BlueprintPure, BlueprintImplementableEvent, Category="Inventory")
 	bool GetUnitEquippedWeaponRange(uint8& MinRange, uint8& MaxRange, bool& TargetsEnemies, bool& TargetsAllies);	// returns true if the unit has an equipped weapon. 
 
-	uint8 GetUnitMovementForTile(uint8 TerrainType);			// Gets the number of tiles a unit can pass on the target tile
+	uint8 GetUnitMovementForTile(uint8 TerrainType) const;		// Gets the number of tiles a unit can pass on the target tile - one table index
+
+	TConstArrayView<uint8> GetUnitMoveCostTable() const;		// Move cost for every terrain type byte. Empty if the unit has no movement data.
 
-	// Unit surrounding data
+	const FMovementCostTable* GetUnitCostTable() const;		// Compiled movement data, or nullptr if the unit has no movement data
+
+	// Fills a reachability query for this unit standing on StartTile. The weapon range is only asked from blueprint when bWithWeapon is set.
+	void MakeReachabilityQuery(UTileGridSubsystem& TileGrid, int32 StartTile, int32 MoveBudget, bool bWithWeapon, FTileReachabilityQuery& OutQuery);
+
+	// Fills the query used to highlight this unit's options when it is selected on StartTile - its remaining movement, and its weapon while it has an action left
+	void MakeSelectionQuery(UTileGridSubsystem& TileGrid, int32 StartTile, FTileReachabilityQuery& OutQuery);
+
+	static uint32 GetHostileFactionMask(uint8 Faction);		// Bit (1 << faction) for each faction hostile to this faction
+	static uint32 GetAlliedFactionMask(uint8 Faction);		// Bit (1 << faction) for each faction allied with this faction
+
+	// Unit surrounding data - range is Manhattan distance on the (X, Y) grid, the same as weapon range
 	UFUNCTION(BlueprintCallable)
 	void GetUnitsInRange(const uint8 MinRange, const uint8 MaxRange, const TArray<TEnumAsByte<EUnitFaction>> TargetFactions, AGameTile* CurrentTile, TArray<AGameTile*> SearchedTiles, TArray<AGameUnit*>& FoundUnits, const uint8 SearchDepth); // Find nearby units in range
 
@@ -152,4 +194,6 @@ protected:
 	virtual void InitializeSetUnitOnInitialTile();	// Traces for a tile below this unit and links with it if one is found
 
 	virtual void InitializeUnitMovementData();		// Links to the unit movement data component
+
+	virtual void InitializeBaseMovementSpaces();	// Fills an unset BaseMovementSpaces from the movement stat ResetUnitMovementAndActions grants in Blueprint
 };
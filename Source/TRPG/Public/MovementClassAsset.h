@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameTile.h"
+#include "Engine/DataAsset.h"
+#include "MovementClassAsset.generated.h"
+
+// Terrain stat bonuses packed into 5 bytes
+struct FPackedTerrainBonus
+{
+	uint8	DefStatBoost	= 0;
+	uint8	ResStatBoost	= 0;
+	uint8	AvoStatBoost	= 0;
+	uint8	HealFlat		= 0;
+	uint8	HealPercent		= 0;
+};
+
+// Terrain data of one movement class flattened by terrain type byte, so every lookup is a single array index.
+struct TRPG_API FMovementCostTable
+{
+public:
+
+	uint8				MoveCosts[256];		// Move cost for each terrain type byte. 255 is impassable, and so is any terrain type missing from the data.
+	FPackedTerrainBonus	Bonuses[256];		// Stat bonuses for each terrain type byte
+
+	uint32				Version;			// Unique for every compile of every table - caches built from the table key on it
+
+	uint32				MoveCostHash;		// Hash of MoveCosts - tables with the same costs share a cost grid even when their versions differ
+
+public:
+
+	FMovementCostTable();					// Every terrain type impassable
+
+	void Compile(const TMap<uint8, FTerrainInfo>& TerrainData);
+
+	TConstArrayView<uint8> GetMoveCosts() const { return TConstArrayView<uint8>(MoveCosts, 256); }
+
+	FTerrainInfo GetTerrainInfo(uint8 TerrainType) const;	// Rebuilds the FTerrainInfo for a terrain type, without its name
+};
+
+// A movement class (foot, cavalry, flying...) defined once and shared by every unit of that class.
+// The terrain data is compiled into an FMovementCostTable on load and whenever it is edited.
+UCLASS(BlueprintType)
+class TRPG_API UMovementClassAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement")
+	TMap<uint8, FTerrainInfo> TerrainData;	// Keys are tile types (enum in blueprint), values are how this movement class crosses them
+
+public:
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	const FMovementCostTable& GetCostTable() const { return CostTable; }
+
+	UFUNCTION(BlueprintPure, Category = "Movement")
+	FTerrainInfo GetTerrainInfo(uint8 TerrainType) const;	// Full terrain data including the name - for HUD use, not searches
+
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void CompileCostTable();
+
+protected:
+
+	FMovementCostTable CostTable;
+};
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "TileControlPawn.h"
+#include "TileBitset.h"
+#include "TilePathPlanner.h"
 #include "Components/ActorComponent.h"
 #include "PlayerPathControl.generated.h"
 
@@ -31,6 +33,9 @@ protected:
 
 	ATileControlPawn* TileControlPawn;	// Owner actor 
 
+	UPROPERTY()
+	UTileGridSubsystem* TileGrid;		// Indexed tile data for the current world
+
 	bool IsPathing = false;				// True when a unit is selected and the player is making a path of it
 
 	AGameTile* StartingTile = nullptr;		// The starting tile for the path.
@@ -39,6 +44,12 @@ protected:
 
 	TArray<AGameTile*> CurrentPath = TArray<AGameTile*>();	// The current path of tiles being displayed.
 
+	FTileBitset CurrentPathTiles;		// Tile indices in CurrentPath - kept in sync by UpdateTileDisplaysForNewPath
+
+	TMap<int32, uint8> DisplayedPathArrows;	// Tile index -> arrow state (origin << 4 | target) currently displayed on that tile
+
+	FTilePathPlanner PathPlanner;		// Keeps its scratch arrays between path queries
+
 	ECardinalDirections LastDirection;	// The final direction for the unit when moving.
 
 	uint8 TravelPathTilesTraveled = 0;
@@ -68,11 +79,21 @@ protected:
 
 	virtual void SetIsPathingUnit(const bool IsPathingUnit, AGameTile* StartingUnitTile, const ECardinalDirections StartingUnitPathDirection, const uint8 MaxMovement);	// Sets whether this component should be tracking a path.
 
-	virtual void UpdateTileDisplaysForNewPath(const TArray<AGameTile*> NewPath, const TArray<AGameTile*> PrevPath); // Updates the arrow-displays for the new path
+	virtual void UpdateTileDisplaysForNewPath(const TArray<AGameTile*>& NewPath); // Updates the arrow-displays for the new path. Only tiles whose arrows changed are signaled.
+
+	virtual void ClearPathDisplays();	// Removes the arrows from every displayed path tile
+
+	static uint8 MakePathArrowState(ECardinalDirections Origin, ECardinalDirections Target) { return (uint8)((Origin << 4) | Target); }
+
+	bool IsTileOnCurrentPath(const AGameTile* Tile) const;	// O(1) check against CurrentPathTiles
+
+	void ResetCurrentPathTiles();		// Sizes CurrentPathTiles to the grid and fills it from CurrentPath
+
+	virtual bool CalculateNewPathToReachTile(const TArray<AGameTile*>& Path, const AGameTile* TargetTile, TArray<AGameTile*>& NewPath); // Keeps the longest part of the existing path that still allows reaching the target tile and appends the cheapest route. Returns false if not possible with the current max movement.
+
+	int32 GetTileMoveCost(const AGameTile* Tile) const;				// Movement the selected unit spends entering a tile. 255 if impassable.
 
-	virtual bool CalculateNewPathToReachTile(const TArray<AGameTile*> Path, const AGameTile* TargetTile, TArray<AGameTile*>& NewPath); // Creates the cheapest path from the existing path to the target tile. Returns false if not possible with the current max movement.
-	
-	bool FindPathToReachTileLoop(AGameTile* CurrentTile, const AGameTile* TargetTile, const uint8 PathLength, const uint8 MaxPathLength, const TArray<AGameTile*> SearchPath, TArray<AGameTile*>& FoundPath, uint8& FoundPathLength);
+	int32 GetPathMoveCost(const TArray<AGameTile*>& Path) const;	// Movement spent walking a path. The first tile is where the unit starts and is free.
 
 	// Selecting a destination tile and moving the the position - while still retaining the old position in case the action is canceled
 
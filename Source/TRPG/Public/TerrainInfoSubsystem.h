@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameTile.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TerrainInfoSubsystem.generated.h"
+
+class UTileGridSubsystem;
+
+// World subsystem that memoizes the Blueprint terrain events.
+// AGameTile::GetTerrainInfoForHud/GetTerrainInfoForUnit only depend on the terrain type (and the unit's movement type), so each
+// distinct key is evaluated through Blueprint once, from any tile of that terrain, and served from native tables afterwards.
+// Entries fill on first lookup, since tiles only report their terrain in their own BeginPlay. Call InvalidateTerrainInfo() after
+// scripting changes the terrain rules.
+UCLASS()
+class TRPG_API UTerrainInfoSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	UFUNCTION(BlueprintCallable, Category = "Terrain")
+	void BakeTerrainInfo();					// Evaluates the HUD info of every terrain type present on the map. Call once the tiles have begun play, e.g. before combat.
+
+	UFUNCTION(BlueprintCallable, Category = "Terrain")
+	void InvalidateTerrainInfo();			// Drops every cached entry - the next query asks Blueprint again
+
+	UFUNCTION(BlueprintPure, Category = "Terrain")
+	FTerrainInfo GetTerrainInfoForHud(AGameTile* Tile);
+
+	UFUNCTION(BlueprintPure, Category = "Terrain")
+	FTerrainInfo GetTerrainInfoForUnit(AGameTile* Tile, uint8 UnitMovementType);
+
+protected:
+
+	UPROPERTY()
+	UTileGridSubsystem* TileGrid;
+
+	TArray<FTerrainInfo>	HudInfos;				// HUD info by terrain type
+	TBitArray<>				HudInfoValid;
+
+	TArray<FTerrainInfo>	UnitInfos[256];			// Unit info by movement type, then terrain type. Allocated per movement type on first use.
+	TBitArray<>				UnitInfoValid[256];
+};
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameUnit.h"
+#include "TileBitset.h"
+#include "TileReachability.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ThreatMapSubsystem.generated.h"
+
+class UTileGridSubsystem;
+
+// Reach of one threatening unit, kept so it can be removed or recomputed on its own
+struct FUnitThreat
+{
+	TWeakObjectPtr<AGameUnit>	Unit;
+	int32						StartTile = INDEX_NONE;	// Tile the threat was computed from
+	FTileBitset					ExploredTiles;			// Tiles the search read - a terrain or occupant change anywhere else cannot change this threat
+	TArray<int32>				ThreatenedTiles;		// Tiles in weapon range after a full turn of movement
+};
+
+// World subsystem that keeps, for every tile, how many units of ThreatFaction could attack it next turn (the "danger zone").
+// Each unit's threat is one reachability search with its base movement and weapon range. When tiles change, only the units whose
+// explored tiles include a changed tile, or that moved themselves, are searched again - the map is never recomputed as a whole per action.
+// While the display is on, threatened tiles carry OVERLAY_THREATENED through the UTileOverlaySubsystem.
+UCLASS()
+class TRPG_API UThreatMapSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threat")
+	uint8 ThreatFaction = EUnitFaction::ENEMY;	// Faction of the units whose reach is tracked
+
+	UFUNCTION(BlueprintCallable, Category = "Threat")
+	void SetThreatDisplayEnabled(bool bEnabled);
+
+	UFUNCTION(BlueprintCallable, Category = "Threat")
+	void ToggleThreatDisplay();
+
+	UFUNCTION(BlueprintPure, Category = "Threat")
+	bool IsThreatDisplayEnabled() const { return bDisplayThreats; }
+
+	UFUNCTION(BlueprintCallable, Category = "Threat")
+	int32 GetThreatCount(int32 TileIndex);		// Number of threatening units that can attack a tile
+
+	UFUNCTION(BlueprintCallable, Category = "Threat")
+	void RebuildThreatMap();					// Searches every threatening unit again - call after weapons or base movement change
+
+	void UpdateThreatMap();						// Searches only the units affected by the tiles changed since the last update
+
+protected:
+
+	void OnTileChanged(int32 TileIndex);
+
+	void ComputeUnitThreat(FUnitThreat& Threat);	// Removes the unit's old threat and adds its current one
+
+	void RemoveUnitThreat(FUnitThreat& Threat);
+
+	void AddThreat(int32 TileIndex, int32 Delta);
+
+	bool IsThreatUnit(const AGameUnit* Unit) const;
+
+	UPROPERTY()
+	UTileGridSubsystem* TileGrid;
+
+	TArray<uint16>		ThreatCounts;		// Threatening units in range of each tile
+	TArray<FUnitThreat>	UnitThreats;
+
+	TArray<int32>		ChangedTiles;		// Tiles changed since the last update, each listed once
+	FTileBitset			ChangedTileSet;
+
+	FTileReachabilityResult SearchResult;	// Scratch - kept between searches
+
+	FDelegateHandle		TileChangedHandle;
+
+	bool bNeedsRebuild		= true;
+	bool bDisplayThreats	= false;
+};
@@ -11,11 +11,15 @@
 #include "GamePlayerController.h"
 #include "TileDataActor.h"
 #include "GameTile.h"
+#include "TileGridData.h"
+#include "TileBitset.h"
+#include "TileReachability.h"
 #include "GameFramework/Pawn.h"
 #include "TileControlPawn.generated.h"
 
 
 class UPlayerPathControl;
+class UTileGridSubsystem;
 
 // FZoomLevelData stores zoom-level data
 USTRUCT(BlueprintType)
@@ -153,9 +157,17 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual void SetUnitActionComplete(AGameUnit* Unit, bool AllowMovement, uint8 RemainingMovement);	// Decrements unit remaining actions
 
+	virtual void ClearUnitSelection();		// Drops the selected unit and any move or action in progress without moving the unit back - used when the battle is rewound
+
 
 	ECardinalDirections GetCurrentCameraRotation();	// Returns the current cam rotation
 
+	AGameTile* GetAdjacentTile(AGameTile* Tile, ETileNeighbor Direction) const;	// Neighbor lookup through the tile grid indices
+
+	const FTileBitset& GetNavigableTiles() const;		// Tiles the selected unit can move onto or through
+
+	const FTileReachabilityResult& GetSelectedUnitReachability() const;	// Distance and predecessor fields for the selected unit
+
 protected:
 
 	bool IsOutOfCombat = true;	// True when the game is not in the combat state
@@ -202,6 +214,9 @@ protected:
 
 	ATileDataActor* TileData;	// An actor spawned on every combat level to store certain data - such as the first tile to hover
 
+	UPROPERTY()
+	UTileGridSubsystem* TileGrid;	// Indexed tile data for the current world
+
 	ECardinalDirections CurrentViewRotation = ECardinalDirections::UP_DIR;	// The current camera rotation. Up = facing north, Right = facing east, Down = facing south, Left = facing west.
 
 	UPROPERTY(BlueprintReadOnly)
@@ -211,9 +226,11 @@ protected:
 
 	FZoomLevelData CurrentZoomSetting = ZoomMedSettings;	// Current zoom
 
-	TArray<AGameTile*> NavigableTiles = TArray<AGameTile*>();		// Tiles that can be travel to when a unit is selected
-	TArray<AGameTile*> AttackableTiles = TArray<AGameTile*>();		// Tiles that can be attacked when a unit is selected
-	TArray<AGameTile*> InteractableTiles = TArray<AGameTile*>();	// Tiles that can be interacted with when a unit is selected
+	FTileBitset NavigableTiles;		// Tiles that can be travel to when a unit is selected
+	FTileBitset AttackableTiles;	// Tiles that can be attacked when a unit is selected
+	FTileBitset InteractableTiles;	// Tiles that can be interacted with when a unit is selected
+
+	FTileReachabilityResult SelectedUnitReachability;	// Reachability search behind the current highlight sets
 
 	TArray<AGameUnit*> TargetableActionUnits = TArray<AGameUnit*>();		// Units that can be targeted for a current action
 	AGameUnit* CurrentTargetableActionUnit = nullptr;						// The current targetet unit for a current action
@@ -270,12 +287,12 @@ protected:
 	UFUNCTION()
 	virtual void CancelUnitTargetingPhase();								// Called when this unit is no longer choosing between units for their action
 
-	// Gets selected-unit surrounding tile displays and signals to the tiles to display this info. Saves these tile pointers.
-	static void GetAvailableTilesForSelectedUnit(AGameTile* CurrentSelectedUnit, AGameUnit* SelectedUnit, TArray<AGameTile*>& NavigableTiles, TArray<AGameTile*>& AttackableTiles, TArray<AGameTile*>& InteractableTiles);
+	// Gets selected-unit surrounding tiles as tile index sets.
+	// Runs one bucket-queue reachability search over the tile grid for movement, attack and interaction tiles, or reuses a cached one from UTileReachabilitySubsystem.
+	static void GetAvailableTilesForSelectedUnit(AGameTile* CurrentSelectedUnit, AGameUnit* SelectedUnit, FTileBitset& NavigableTiles, FTileBitset& AttackableTiles, FTileBitset& InteractableTiles, FTileReachabilityResult& Reachability);
 
-	static void GetAvailableTilesLoop(AGameUnit* CurrentSelectedUnit, AGameTile* CurrentTile, uint8 MaxTileDistance, uint8 CurrentTileDistance, uint8 NavigationDistance, uint8 InteractionDistance,
-		uint8 WeaponActDistanceMin, uint8 WeaponActInstanceMax, bool weaponTargetsEnemies, bool weaponTargetsAllies, 
-		TArray<AGameTile*>& FoundNavigableTiles, TArray<AGameTile*>& FoundAttackableTiles, TArray<AGameTile*>& FoundInteractableTiles, TArray<AGameTile*> checkedTiles);
+	// Queues the tiles that changed between the current and new highlight sets on the UTileOverlaySubsystem, then saves the new sets
+	virtual void SetHighlightedTiles(const FTileBitset& NewNavigableTiles, const FTileBitset& NewAttackableTiles, const FTileBitset& NewInteractableTiles);
 
 	virtual void ClearSelectedTileData();
 
@@ -319,4 +336,7 @@ protected:
 	UFUNCTION()
 	virtual void InputCancelTile();			// Deselects the currently selected tile
 
+	UFUNCTION()
+	virtual void InputToggleThreatDisplay();	// Shows or hides every tile an enemy can attack next turn
+
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameTile.h"
+#include "TileGridData.h"
 #include "GameFramework/Actor.h"
 #include "TileDataActor.generated.h"
 
@@ -35,4 +36,24 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	TArray<AGameTile*> PlayerStartingTiles;
 
+	UPROPERTY(VisibleAnywhere, Category = "Tile Graph")
+	TArray<AGameTile*> BakedGraphTiles;			// Tile actor for each baked graph record. Set by BakeTileGraph().
+
+	TArray<FTileGraphRecord> BakedGraphRecords;	// Coordinates, terrain and adjacency of every tile on the map. Serialized as one block.
+
+	uint32 BakedTileLayoutHash = 0;				// ComputeTileLayoutHash() of the map when the graph was baked. Serialized with the records.
+
+public:
+
+	void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	UFUNCTION(CallInEditor, Category = "Tile Graph")
+	virtual void BakeTileGraph();				// Links every tile on the map and stores the tile graph. Called automatically on save.
+
+	bool HasValidBakedTileGraph() const;		// True when every baked record still has its tile actor and no tile was added, removed or moved since the bake
+
+	static uint32 ComputeTileLayoutHash(UWorld* World);	// Order-independent hash of the integer coordinate of every tile actor in the world
+
 };
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileGridData.h"
+#include "TileReachability.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TileGridSubsystem.generated.h"
+
+class AGameTile;
+class AGameUnit;
+class ATileDataActor;
+class ATileInstanceManager;
+struct FMovementCostTable;
+enum ECardinalDirections : uint8;
+
+// Move cost of every tile for one set of terrain move costs, materialized from an FMovementCostTable
+struct FTileCostGrid
+{
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Costs;	// Cost of entering each tile, by tile index. 255 is blocked. Never written once built.
+	uint8 MoveCosts[256];		// Terrain move costs the grid was built from - tells tables with the same hash apart
+	uint32 TerrainEpoch = 0;	// Terrain epoch the costs were built at
+	uint64 LastUsed = 0;		// CostGridUseCounter value of the last lookup - the lowest is evicted first
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FTileGridTileChanged, int32 /*TileIndex*/);
+
+// World subsystem that indexes every AGameTile at map load.
+// Tiles receive an integer index and coordinate, and terrain, occupancy and neighbor links are kept in flat arrays (FTileGridData)
+// so tile searches can run on indices instead of hopping through tile actor pointers.
+UCLASS()
+class TRPG_API UTileGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void RebuildTileGrid();		// Indexes and links every tile in the world. Called before any actor BeginPlay.
+
+	FTileGridTileChanged OnTileChanged;	// Fires when a tile's terrain or occupant changes
+
+	static void BuildGridFromTiles(UWorld* World, TArray<AGameTile*>& OutTiles, FTileGridData& OutGridData);	// Indexes, orders and links every tile actor in the world
+
+	static FIntVector GetTileCoord(const AGameTile* Tile);	// Integer (X, Y, Layer) coordinate of a tile actor - X/Y quantized by the tile spacing and Z banded by the vertical trace range
+
+	static void LinkWorldTileNeighbors(UWorld* World);	// Sets NorthTile/WestTile/EastTile/SouthTile on every tile with the spatial hash linker. Runs once per frame no matter how many tiles call it.
+
+	const FTileGridData& GetGridData() const;	// Flat tile data for index-based searches
+
+	// Read-only copy of the grid data for searches on worker threads. Copied at most once per world epoch and shared until something on the map changes.
+	TSharedRef<const FTileGridData, ESPMode::ThreadSafe> GetGridSnapshot();
+
+	int32 GetTileCount() const;
+
+	AGameTile* GetTile(int32 TileIndex) const;			// Returns the tile actor for an index, or nullptr. Spawns a facade tile for instanced tiles.
+
+	AGameTile* FindTile(int32 TileIndex) const;			// Returns the tile actor for an index only if one exists - never spawns a facade
+
+	void RegisterTileFacade(int32 TileIndex, AGameTile* Tile);	// Called by ATileInstanceManager when it spawns the actor for an instanced tile
+
+	int32 GetTileIndex(const AGameTile* Tile) const;	// Returns the index of a tile, or INDEX_NONE if it is not part of the grid
+
+	int32 GetNeighborIndex(int32 TileIndex, ETileNeighbor Direction) const;
+
+	AGameTile* GetNeighborTile(const AGameTile* Tile, ETileNeighbor Direction) const;	// Index-based replacement for AGameTile::GetNorthTile() etc.
+
+	void SetTileTerrainType(int32 TileIndex, uint8 TerrainType);	// Called by tiles once their terrain type is known
+
+	void SetTileOccupant(int32 TileIndex, AGameUnit* Unit);			// Called by tiles when a unit moves on or off of them
+
+	AGameUnit* GetTileOccupant(int32 TileIndex) const;
+
+	// Units of FactionMask (bit 1 << faction) within [MinRange, MaxRange] Manhattan distance of a tile, read from the faction cell masks
+	void GetUnitsInRange(int32 SourceTile, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<AGameUnit*>& OutUnits) const;
+
+	// Units in range of any of the source tiles - one ring dilation for all of them. Each unit is listed once.
+	void GetUnitsInRangeOfTiles(TConstArrayView<int32> SourceTiles, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<AGameUnit*>& OutUnits) const;
+
+	void ComputeReachability(const FTileReachabilityQuery& Query, FTileReachabilityResult& OutResult);	// Movement and weapon range search over the grid
+
+	// Move cost of every tile for a movement class, by tile index. Built on first use and rebuilt only after terrain changes,
+	// so searches read one contiguous array instead of looking up each tile's terrain.
+	// A rebuild or eviction makes a new array - queries holding the returned reference keep the old one alive.
+	TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> GetMoveCostGrid(const FMovementCostTable& CostTable);
+
+	uint32 GetTerrainEpoch() const { return TerrainEpoch; }	// Changes whenever any tile's terrain changes
+
+	uint32 GetWorldEpoch() const { return WorldEpoch; }		// Changes whenever any tile's terrain or occupant changes - cached search results older than this are stale
+
+	void BumpWorldEpoch() { WorldEpoch++; }
+
+	static ETileNeighbor CardinalToNeighbor(ECardinalDirections Direction);		// UP = North, LEFT = West, RIGHT = East, DOWN = South
+
+	static ECardinalDirections NeighborToCardinal(ETileNeighbor Direction);
+
+protected:
+
+	virtual void LoadBakedTileGraph(const ATileDataActor& TileData);	// Loads the tile graph baked on save instead of rebuilding it from the tile actors
+
+	virtual void LoadInstancedTiles(ATileInstanceManager& InstanceManager);	// Loads tiles converted to instances. Tile actors are spawned on demand.
+
+	static void LinkTiles(const TArray<AGameTile*>& TilesToLink, TArray<int32> (&OutNeighbors)[NEIGHBOR_COUNT]);	// Runs the spatial hash linker over the tiles and stores the results on the tile actors
+
+	FTileGridData GridData;
+
+	FTileReachabilityEngine ReachabilityEngine;	// Keeps its scratch arrays between searches
+
+	TMap<uint32, FTileCostGrid> CostGrids;		// Cost grid for each FMovementCostTable::MoveCostHash in use - units with the same costs share one
+
+	uint64 CostGridUseCounter = 0;
+
+	uint32 TerrainEpoch = 1;
+
+	uint32 WorldEpoch = 1;
+
+	TSharedPtr<const FTileGridData, ESPMode::ThreadSafe> GridSnapshot;	// Last copy handed out by GetGridSnapshot()
+
+	uint32 GridSnapshotEpoch = 0;		// World epoch GridSnapshot was copied at
+
+	uint64 LastLinkedFrame = MAX_uint64;	// Frame LinkWorldTileNeighbors() last linked this world's tiles
+
+	UPROPERTY()
+	TArray<AGameTile*> Tiles;				// Tile actor for each index. nullptr for instanced tiles until their facade is spawned.
+
+	UPROPERTY()
+	ATileInstanceManager* TileInstanceManager;	// Set when the map's tiles are instanced
+
+	UPROPERTY()
+	TArray<AGameUnit*> TileOccupants;		// Unit on each tile index
+};
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileGridData.h"
+#include "GameFramework/Actor.h"
+#include "TileInstanceManager.generated.h"
+
+class AGameTile;
+class UHierarchicalInstancedStaticMeshComponent;
+class UTileGridSubsystem;
+
+// Per-instance custom data slots on the tile instances. Tile materials read these to show terrain and highlights.
+enum ETileInstanceCustomData : int32
+{
+	TILE_CUSTOM_DATA_TERRAIN	= 0,	// Terrain type byte
+	TILE_CUSTOM_DATA_OVERLAY	= 1,	// ETileOverlayFlags
+	TILE_CUSTOM_DATA_COUNT		= 2
+};
+
+// Optional replacement for one AGameTile actor per tile on large maps.
+// ConvertTilesToInstances() turns the tiles placed on the map into tile graph records and one hierarchical instanced mesh,
+// with instance N drawing tile index N. At runtime UTileGridSubsystem loads the records, and AGameTile actors are only
+// spawned from FacadeTileClass when something asks for a tile actor - the hovered tile, a unit's tile, a path tile.
+// Highlight changes from UTileOverlaySubsystem are written to the instance custom data instead of going through tile actors.
+UCLASS()
+class TRPG_API ATileInstanceManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ATileInstanceManager();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UHierarchicalInstancedStaticMeshComponent* TileInstances;	// One instance per tile, in tile index order
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tile Instances")
+	TSubclassOf<AGameTile> FacadeTileClass;		// Tile actor spawned on demand for a tile. Should not draw the tile mesh itself - the instances already do.
+
+	UPROPERTY(VisibleAnywhere, Category = "Tile Instances")
+	TArray<AGameTile*> PlacedFacadeTiles;		// Facade tiles kept in the level because the ATileDataActor references them. Set by ConvertTilesToInstances().
+
+	TArray<FTileGraphRecord> TileRecords;		// Coordinates, terrain and adjacency of every tile. Serialized as one block.
+
+public:
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	UFUNCTION(CallInEditor, Category = "Tile Instances")
+	virtual void ConvertTilesToInstances();		// Replaces every AGameTile on the map with an instance and a tile graph record
+
+	bool HasTileRecords() const;				// True when the records and instances describe the same tiles
+
+	UFUNCTION(BlueprintCallable, Category = "Tile Instances")
+	AGameTile* GetTileFacade(int32 TileIndex);	// Returns the tile actor for an index, spawning a facade the first time
+
+	void SetInstanceTerrainType(int32 TileIndex, uint8 TerrainType);	// Called by the tile grid when a tile's terrain changes
+
+protected:
+
+	void OnTileOverlaysChanged(TConstArrayView<int32> TileIndices, TConstArrayView<uint8> TileFlags);	// Writes the batched highlight changes into the instance custom data
+
+	UTileGridSubsystem* GetTileGrid() const;
+
+	FDelegateHandle TileOverlaysChangedHandle;
+};
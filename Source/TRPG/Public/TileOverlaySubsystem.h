@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileBitset.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TileOverlaySubsystem.generated.h"
+
+class UTileGridSubsystem;
+enum ETileOverlayFlags : uint8;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FTileOverlaysChangedNative, TConstArrayView<int32> /*TileIndices*/, TConstArrayView<uint8> /*TileFlags*/);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FTileOverlaysChanged, const TArray<int32>&, TileIndices, const TArray<uint8>&, TileFlags);
+
+// World subsystem that batches tile highlight changes.
+// Tile state (AGameTile::GetIsNavigable() etc.) changes immediately, but events are collected and flushed once per frame:
+// one native and one Blueprint event carrying every changed tile index and its new ETileOverlayFlags.
+// Selecting or deselecting a unit is one dispatch no matter how many tiles it touches.
+// Tiles with bUsePerTileOverlayEvents set also fire their own set/unset events on flush.
+UCLASS()
+class TRPG_API UTileOverlaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	FTileOverlaysChangedNative OnTileOverlaysChangedNative;	// Fires once per frame with every tile whose flags changed
+
+	UPROPERTY(BlueprintAssignable, Category = "Tile")
+	FTileOverlaysChanged OnTileOverlaysChanged;			// Fires once per frame with every tile whose flags changed. TileIndices match UTileGridSubsystem indices.
+
+	void SetTileOverlayFlag(int32 TileIndex, ETileOverlayFlags Flag, bool Toggle);	// Sets or clears one flag on a tile and queues the change
+
+	uint8 GetTileOverlayFlags(int32 TileIndex) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Tile")
+	void FlushTileOverlayChanges();		// Sends the queued changes now instead of on the next tick
+
+protected:
+
+	void PrepareTileArrays();			// Sizes the flag arrays to the tile grid
+
+	UPROPERTY()
+	UTileGridSubsystem* TileGrid;
+
+	TArray<uint8>	TileFlags;			// Current flags of each tile
+	TArray<uint8>	BroadcastFlags;		// Flags of each tile as of the last flush
+
+	TArray<int32>	DirtyTiles;			// Tiles changed since the last flush, each listed once
+	FTileBitset		DirtyTileSet;
+
+	TArray<int32>	ChangedTileIndices;	// Flush scratch - kept to avoid reallocating every frame
+	TArray<uint8>	ChangedTileFlags;
+};
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileBitset.h"
+#include "TileReachability.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "TileReachabilitySubsystem.generated.h"
+
+class AGameUnit;
+class UTileGridSubsystem;
+
+// Everything a reachability search depends on besides the world state
+struct FTileReachabilityCacheKey
+{
+	TObjectKey<AGameUnit> Unit;
+	int32	StartTile			= INDEX_NONE;
+	int32	MoveBudget			= 0;
+	uint32	CostTableVersion	= 0;	// FMovementCostTable::Version of the unit's movement data
+	uint32	HostileFactions		= 0;
+	uint32	AlliedFactions		= 0;
+	uint8	MinActRange			= 0;
+	uint8	MaxActRange			= 0;
+	bool	bTargetsEnemies		= false;
+	bool	bTargetsAllies		= false;
+
+	bool operator==(const FTileReachabilityCacheKey& Other) const
+	{
+		return Unit == Other.Unit && StartTile == Other.StartTile && MoveBudget == Other.MoveBudget && CostTableVersion == Other.CostTableVersion
+			&& HostileFactions == Other.HostileFactions && AlliedFactions == Other.AlliedFactions && MinActRange == Other.MinActRange
+			&& MaxActRange == Other.MaxActRange && bTargetsEnemies == Other.bTargetsEnemies && bTargetsAllies == Other.bTargetsAllies;
+	}
+
+	friend uint32 GetTypeHash(const FTileReachabilityCacheKey& Key)
+	{
+		uint32 hash = HashCombine(GetTypeHash(Key.Unit), GetTypeHash(Key.StartTile));
+		hash = HashCombine(hash, GetTypeHash(Key.MoveBudget | (Key.MinActRange << 16) | (Key.MaxActRange << 24)));
+		hash = HashCombine(hash, GetTypeHash(Key.CostTableVersion));
+		return HashCombine(hash, GetTypeHash(Key.HostileFactions ^ (Key.AlliedFactions << 8) ^ (Key.bTargetsEnemies << 16) ^ (Key.bTargetsAllies << 17)));
+	}
+};
+
+// A reachability result with the tile sets the selection highlight uses
+struct FCachedReachability
+{
+	FTileReachabilityResult	Result;
+	FTileBitset				NavigableTiles;
+	FTileBitset				AttackableTiles;
+	FTileBitset				InteractableTiles;
+
+	uint64	LastUsed		= 0;	// Use counter value of the last lookup - the lowest is evicted first
+	int64	AllocatedBytes	= 0;
+
+	void BuildTileSets(int32 TileCount);	// Fills the tile sets and AllocatedBytes from Result
+};
+
+// One reachability search that can run off the game thread. Owns copies of everything the query points at.
+struct FTileReachabilityJob
+{
+	FTileReachabilityCacheKey	Key;
+	FTileReachabilityQuery		Query;
+	TArray<uint8>				MoveCosts;		// Copy of Query.MoveCosts. Query.TileCostsOwner shares the tile costs instead of copying them.
+	uint32						WorldEpoch	= 0;	// World epoch the query was built at - the result is dropped if the map changed since
+
+	FCachedReachability			Entry;			// Filled by Run()
+
+	void Run(const FTileGridData& Grid, FTileReachabilityEngine& Engine);	// Safe on any thread as long as Grid is not written
+};
+
+// A job searching on a background task. The task owns references to the job and the grid snapshot, so dropping this does not cancel it.
+struct FPendingReachabilityJob
+{
+	TSharedPtr<FTileReachabilityJob, ESPMode::ThreadSafe>	Job;
+	UE::Tasks::FTask										Task;
+};
+
+// World subsystem that keeps recent reachability results.
+// Reselecting a unit, or hovering back and forth between units, returns the stored result as long as nothing on the map changed.
+// Every entry is dropped when UTileGridSubsystem's world epoch moves (a unit moved, appeared or died, or terrain changed),
+// and the least recently used entries are evicted to stay within MaxEntries and MaxCachedBytes.
+// PrecomputeReachability() fills the cache for a whole faction at once, so the first selection of each unit in a phase is a hit too.
+// PrefetchReachability() searches a hovered unit on a background task; its result is only stored if the world epoch has not moved since.
+UCLASS()
+class TRPG_API UTileReachabilitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	// Returns the reachability of a unit for a query, searching only on a cache miss.
+	// The reference stays valid until the next call.
+	const FCachedReachability& GetReachability(const AGameUnit* Unit, const FTileReachabilityQuery& Query, uint32 CostTableVersion);
+
+	// Searches the selection reachability of every unit in parallel on worker threads, over a read-only snapshot of the grid,
+	// and stores the results so selecting any of them is a cache hit. Called when the units' phase starts.
+	void PrecomputeReachability(TConstArrayView<AGameUnit*> Units);
+
+	// Starts searching a unit's selection reachability from StartTile on a background task, so selecting or previewing it later is a cache hit.
+	// Does nothing if the result is already stored or being searched. Called when the cursor hovers a unit.
+	void PrefetchReachability(AGameUnit* Unit, int32 StartTile);
+
+	// Builds a self-contained job for a query. Game thread only - the query is built from the unit.
+	void MakeJob(const AGameUnit* Unit, const FTileReachabilityQuery& Query, uint32 CostTableVersion, FTileReachabilityJob& OutJob) const;
+
+	// Stores a finished job's result. Returns false, and stores nothing, if the map changed after the job was built.
+	bool AddJobResult(FTileReachabilityJob& Job);
+
+	UFUNCTION(BlueprintCallable, Category = "Tile")
+	void ClearCache();
+
+	UPROPERTY(EditAnywhere, Category = "Tile")
+	int32 MaxEntries = 32;
+
+	UPROPERTY(EditAnywhere, Category = "Tile")
+	int64 MaxCachedBytes = 8 * 1024 * 1024;
+
+	UPROPERTY(EditAnywhere, Category = "Tile")
+	int32 MaxPendingJobs = 4;		// Prefetches running at once - sweeping the cursor across many units does not queue a search for each
+
+protected:
+
+	static FTileReachabilityCacheKey MakeCacheKey(const AGameUnit* Unit, const FTileReachabilityQuery& Query, uint32 CostTableVersion);
+
+	void SyncWorldEpoch();		// Drops every entry if the world epoch moved since they were computed
+
+	void CollectPendingJobs(const FTileReachabilityCacheKey* WaitKey = nullptr);	// Stores finished prefetches and drops stale ones. Waits for the prefetch of WaitKey if one is running.
+
+	FCachedReachability& AddEntry(const FTileReachabilityCacheKey& Key, FCachedReachability&& Entry);	// Stores an entry and evicts others to stay in budget
+
+	void EvictToBudget(const FTileReachabilityCacheKey& KeepKey);	// Drops least recently used entries until the cache fits its budget
+
+	UPROPERTY()
+	UTileGridSubsystem* TileGrid;
+
+	TMap<FTileReachabilityCacheKey, FCachedReachability> Entries;
+
+	TArray<FPendingReachabilityJob> PendingJobs;
+
+	uint32	CachedWorldEpoch	= 0;	// World epoch the entries were computed at
+	uint64	UseCounter			= 0;
+	int64	CachedBytes			= 0;
+};
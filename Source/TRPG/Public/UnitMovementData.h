@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameTile.h"
+#include "MovementClassAsset.h"
 #include "Components/ActorComponent.h"
 #include "UnitMovementData.generated.h"
 
@@ -27,17 +28,31 @@ public:
 
 protected:
 
-	TMap<uint8, FTerrainInfo> MoveCostMap = TMap<uint8, FTerrainInfo>();	// Map where keys are tile types (enum in blueprint) and values are FTerrainInfo structs (precalculated by unit on start)
+	TMap<uint8, FTerrainInfo> MoveCostMap = TMap<uint8, FTerrainInfo>();	// Map where keys are tile types (enum in blueprint) and values are FTerrainInfo structs. Only used without a MovementClass.
+
+	FMovementCostTable OwnCostTable;		// Compiled from MoveCostMap when the unit has no MovementClass
+
+	const FMovementCostTable* CostTable = &OwnCostTable;	// The movement class's shared table, or OwnCostTable
 
 public:
 
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement")
+	UMovementClassAsset* MovementClass;		// Shared movement data. When set, InitializeMovementMap/SetMovementMap are not needed.
+
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent)
 	void InitializeMovementMap();			// blueprint function to initialize the movement map (mapping tile types to move costs)
 
 	UFUNCTION(BlueprintCallable)
-	void SetMovementMap(TMap<uint8, FTerrainInfo> NewTerrainData);
+	void SetMovementMap(TMap<uint8, FTerrainInfo> NewTerrainData);	// Per-unit movement data - prefer a MovementClass shared by every unit of the class
+
+	UFUNCTION(BlueprintCallable)
+	void SetMovementClass(UMovementClassAsset* NewMovementClass);
+
+	uint8 GetMoveCostInfo(uint8 TileType) const { return CostTable->MoveCosts[TileType]; }	// Gets the move cost for a tile type for this specific unit
+
+	TConstArrayView<uint8> GetMoveCostTable() const;	// Move cost for every tile type byte. 255 for tile types missing from the data.
 
-	uint8 GetMoveCostInfo(uint8 TileType);	// Gets the move cost for a tile type for this specific unit
+	const FMovementCostTable& GetCostTable() const { return *CostTable; }
 
 	FTerrainInfo GetTerrainPassingInfo(uint8 TileType); // Gets all terrain passing info for a tile type for this specific unit
 		
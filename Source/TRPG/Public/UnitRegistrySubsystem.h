@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameUnit.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UnitRegistrySubsystem.generated.h"
+
+// A unit's activation visuals waiting to be applied
+struct FQueuedUnitCosmetics
+{
+	TWeakObjectPtr<AGameUnit>	Unit;
+	bool						bActivated = false;
+};
+
+// World subsystem that keeps every unit in play in a dense array for its faction.
+// Units register in BeginPlay and unregister in EndPlay, and faction changes go through SetUnitFaction, so phase logic and
+// unit counts read one faction's array instead of scanning every actor in the world.
+// Per-unit activation visuals queued by a phase change are applied over the following frames, MaxCosmeticUpdatesPerFrame at a time.
+UCLASS()
+class TRPG_API UUnitRegistrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	UPROPERTY(EditAnywhere, Category = "Units")
+	int32 MaxCosmeticUpdatesPerFrame = 16;
+
+	void RegisterUnit(AGameUnit* Unit);			// Adds a unit to the array of its faction. Called by the unit in BeginPlay.
+
+	void UnregisterUnit(AGameUnit* Unit);		// Removes a unit from its faction array. Called by the unit in EndPlay.
+
+	UFUNCTION(BlueprintCallable, Category = "Units")
+	void SetUnitFaction(AGameUnit* Unit, uint8 NewFaction);	// Moves a unit to another faction and updates the faction of its tile
+
+	const TArray<AGameUnit*>& GetFactionUnits(uint8 Faction) const;	// Every registered unit of a faction, in no particular order
+
+	UFUNCTION(BlueprintCallable, Category = "Units")
+	TArray<AGameUnit*> GetUnitsOfFaction(uint8 Faction) const { return GetFactionUnits(Faction); }
+
+	UFUNCTION(BlueprintPure, Category = "Units")
+	int32 GetFactionUnitCount(uint8 Faction) const { return GetFactionUnits(Faction).Num(); }
+
+	void QueueActivationCosmetics(TConstArrayView<AGameUnit*> Units, bool bActivated);	// Applies AGameUnit::ApplyActivationCosmetics to the units over the next frames
+
+	void FlushActivationCosmetics();			// Applies every queued update now
+
+protected:
+
+	// Units of each faction. Each unit stores its slot, so removal is a swap with the last unit.
+	// Not a UPROPERTY - units remove themselves in EndPlay before they can be collected.
+	TArray<AGameUnit*> FactionUnits[UNIT_FACTION_COUNT];
+
+	TArray<FQueuedUnitCosmetics>	QueuedCosmetics;	// Applied in order from QueuedCosmeticsStart
+	int32							QueuedCosmeticsStart = 0;
+};
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BattleHistory.h"
+
+void FBattleHistory::Reset()
+{
+	Grid.Reset();
+	Snapshots.Reset();
+}
+
+int32 FBattleHistory::TakeSnapshot(const FBattleState& State)
+{
+	if (Snapshots.IsEmpty() || !State.Grid.HasSameLayout(Grid))
+	{
+		Reset();
+		Grid = State.Grid;
+		for (int32 tileIndex = 0; tileIndex < Grid.Num(); tileIndex++)
+		{
+			Grid.SetOccupantFaction(tileIndex, BATTLE_FACTION_NONE);
+		}
+	}
+
+	const FBattleSnapshot* previous = Snapshots.Num() ? &Snapshots.Last() : nullptr;
+
+	FBattleSnapshot snapshot;
+	snapshot.Units = WritePages(State.Units.GetData(), State.Units.Num() * (int32)sizeof(FBattleUnit), previous ? previous->Units : nullptr);
+	snapshot.MoveCostTables = WritePages(State.MoveCostTables.GetData(), State.MoveCostTables.Num(), previous ? previous->MoveCostTables : nullptr);
+	snapshot.ActiveFaction = State.ActiveFaction;
+	snapshot.RoundNumber = State.RoundNumber;
+	return Snapshots.Add(MoveTemp(snapshot));
+}
+
+bool FBattleHistory::RestoreSnapshot(int32 SnapshotIndex, FBattleState& State) const
+{
+	if (!Snapshots.IsValidIndex(SnapshotIndex))
+	{
+		return false;
+	}
+	const FBattleSnapshot& snapshot = Snapshots[SnapshotIndex];
+
+	if (!State.Grid.HasSameLayout(Grid) || State.TileUnits.Num() != Grid.Num())
+	{
+		State.InitTiles(Grid);	// not on this battle's map - start from the clear tile graph and its terrain
+	}
+	else
+	{
+		State.ClearUnits();		// only the tiles the current units stand on are touched
+	}
+
+	State.Units.SetNumUninitialized(snapshot.Units->NumBytes / (int32)sizeof(FBattleUnit));
+	ReadPages(*snapshot.Units, State.Units.GetData());
+	for (int32 unitIndex = 0; unitIndex < State.Units.Num(); unitIndex++)
+	{
+		const FBattleUnit& unit = State.Units[unitIndex];
+		if (unit.IsInBattle())
+		{
+			State.TileUnits[unit.Tile] = unitIndex;
+			State.Grid.SetOccupantFaction(unit.Tile, unit.Faction);
+		}
+	}
+
+	State.MoveCostTables.SetNumUninitialized(snapshot.MoveCostTables->NumBytes);
+	ReadPages(*snapshot.MoveCostTables, State.MoveCostTables.GetData());
+
+	State.ActiveFaction = snapshot.ActiveFaction;
+	State.RoundNumber = snapshot.RoundNumber;
+	return true;
+}
+
+void FBattleHistory::TruncateSnapshots(int32 NumSnapshots)
+{
+	if (NumSnapshots < Snapshots.Num())
+	{
+		Snapshots.SetNum(FMath::Max(NumSnapshots, 0));	// pages still used by the kept snapshots stay alive through their references
+	}
+}
+
+int64 FBattleHistory::GetAllocatedSize() const
+{
+	int64 allocatedBytes = Grid.Coords.GetAllocatedSize() + Grid.TerrainTypes.GetAllocatedSize() + Grid.OccupantFactions.GetAllocatedSize()
+		+ Grid.CellFirstTile.GetAllocatedSize() + Grid.NextTileInCell.GetAllocatedSize() + Snapshots.GetAllocatedSize();
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		allocatedBytes += Grid.Neighbors[dir].GetAllocatedSize();
+	}
+
+	// Shared page lists and pages are counted once
+	TSet<const void*> countedPages;
+	for (const FBattleSnapshot& snapshot : Snapshots)
+	{
+		for (const FBattlePageArray* pageArray : { snapshot.Units.Get(), snapshot.MoveCostTables.Get() })
+		{
+			bool bAlreadyCounted = false;
+			countedPages.Add(pageArray, &bAlreadyCounted);
+			if (bAlreadyCounted)
+			{
+				continue;
+			}
+			allocatedBytes += sizeof(FBattlePageArray) + pageArray->Pages.GetAllocatedSize();
+
+			for (const TSharedRef<const TArray<uint8>>& page : pageArray->Pages)
+			{
+				countedPages.Add(&page.Get(), &bAlreadyCounted);
+				if (!bAlreadyCounted)
+				{
+					allocatedBytes += sizeof(TArray<uint8>) + page->GetAllocatedSize();
+				}
+			}
+		}
+	}
+	return allocatedBytes;
+}
+
+TSharedPtr<const FBattlePageArray> FBattleHistory::WritePages(const void* Data, int32 NumBytes, const TSharedPtr<const FBattlePageArray>& Previous)
+{
+	const uint8* bytes = (const uint8*)Data;
+	const int32 pageCount = FMath::DivideAndRoundUp(NumBytes, BATTLE_HISTORY_PAGE_BYTES);
+
+	TSharedRef<FBattlePageArray> pageArray = MakeShared<FBattlePageArray>();
+	pageArray->NumBytes = NumBytes;
+	pageArray->Pages.Reserve(pageCount);
+
+	bool bChanged = !Previous.IsValid() || Previous->NumBytes != NumBytes;
+	for (int32 pageIndex = 0; pageIndex < pageCount; pageIndex++)
+	{
+		const int32 pageOffset = pageIndex * BATTLE_HISTORY_PAGE_BYTES;
+		const int32 pageBytes = FMath::Min(NumBytes - pageOffset, BATTLE_HISTORY_PAGE_BYTES);
+
+		if (Previous.IsValid() && Previous->Pages.IsValidIndex(pageIndex))
+		{
+			const TArray<uint8>& previousPage = Previous->Pages[pageIndex].Get();
+			if (previousPage.Num() == pageBytes && FMemory::Memcmp(previousPage.GetData(), bytes + pageOffset, pageBytes) == 0)
+			{
+				pageArray->Pages.Add(Previous->Pages[pageIndex]);	// unchanged - share it
+				continue;
+			}
+		}
+
+		pageArray->Pages.Add(MakeShared<TArray<uint8>>(bytes + pageOffset, pageBytes));
+		bChanged = true;
+	}
+
+	return bChanged ? TSharedPtr<const FBattlePageArray>(pageArray) : Previous;
+}
+
+void FBattleHistory::ReadPages(const FBattlePageArray& PageArray, void* OutData)
+{
+	uint8* bytes = (uint8*)OutData;
+	for (const TSharedRef<const TArray<uint8>>& page : PageArray.Pages)
+	{
+		FMemory::Memcpy(bytes, page->GetData(), page->Num());
+		bytes += page->Num();
+	}
+}
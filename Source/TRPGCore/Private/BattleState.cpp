@@ -0,0 +1,259 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BattleState.h"
+
+void FBattleState::Reset()
+{
+	Grid.Reset();
+	TileUnits.Reset();
+	Units.Reset();
+	MoveCostTables.Reset();
+	ActiveFaction = BATTLE_FACTION_NONE;
+	RoundNumber = 1;
+}
+
+void FBattleState::InitTiles(const FTileGridData& InGrid)
+{
+	Grid = InGrid;
+	for (int32 tileIndex = 0; tileIndex < Grid.Num(); tileIndex++)
+	{
+		Grid.SetOccupantFaction(tileIndex, BATTLE_FACTION_NONE);
+	}
+
+	TileUnits.Init(INDEX_NONE, Grid.Num());
+	Units.Reset();
+}
+
+int32 FBattleState::AddMoveCostTable(TConstArrayView<uint8> MoveCosts)
+{
+	const int32 moveClass = MoveCostTables.Num() / 256;
+	MoveCostTables.AddUninitialized(256);
+	for (int32 terrainType = 0; terrainType < 256; terrainType++)
+	{
+		MoveCostTables[moveClass * 256 + terrainType] = MoveCosts.IsValidIndex(terrainType) ? MoveCosts[terrainType] : BLOCKED_MOVE_COST;
+	}
+	return moveClass;
+}
+
+int32 FBattleState::AddUnit(const FBattleUnit& Unit)
+{
+	if (Unit.IsInBattle() && (!Grid.IsValidTile(Unit.Tile) || TileUnits[Unit.Tile] != INDEX_NONE))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 unitIndex = Units.Add(Unit);
+	Units[unitIndex].Tile = INDEX_NONE;
+	if (Unit.IsInBattle())
+	{
+		SetUnitTile(unitIndex, Unit.Tile);
+	}
+	return unitIndex;
+}
+
+void FBattleState::ClearUnits()
+{
+	for (int32 unitIndex = 0; unitIndex < Units.Num(); unitIndex++)
+	{
+		SetUnitTile(unitIndex, INDEX_NONE);
+	}
+	Units.Reset();
+}
+
+void FBattleState::RemoveUnit(int32 UnitIndex)
+{
+	if (Units.IsValidIndex(UnitIndex))
+	{
+		SetUnitTile(UnitIndex, INDEX_NONE);
+	}
+}
+
+int32 FBattleState::CountUnits(uint8 Faction) const
+{
+	int32 count = 0;
+	for (const FBattleUnit& unit : Units)
+	{
+		count += unit.IsInBattle() && unit.Faction == Faction;
+	}
+	return count;
+}
+
+void FBattleState::MakeUnitQuery(int32 UnitIndex, FTileReachabilityQuery& OutQuery) const
+{
+	const FBattleUnit& unit = Units[UnitIndex];
+
+	OutQuery = FTileReachabilityQuery();
+	OutQuery.StartTile = unit.Tile;
+	OutQuery.MoveBudget = unit.RemainingSpaces;
+	if (MoveCostTables.Num() >= (unit.MoveClass + 1) * 256)
+	{
+		OutQuery.MoveCosts = TConstArrayView<uint8>(MoveCostTables.GetData() + unit.MoveClass * 256, 256);
+	}
+	OutQuery.HostileFactions = GetHostileFactionMask(unit.Faction);
+	OutQuery.AlliedFactions = GetAlliedFactionMask(unit.Faction);
+
+	if (unit.RemainingActions > 0)	// weapon range only while an action is available
+	{
+		OutQuery.MinActRange = unit.MinActRange;
+		OutQuery.MaxActRange = unit.MaxActRange;
+		OutQuery.bTargetsEnemies = unit.bTargetsEnemies;
+		OutQuery.bTargetsAllies = unit.bTargetsAllies;
+	}
+}
+
+void FBattleState::ComputeReachability(int32 UnitIndex, FTileReachabilityEngine& Engine, FTileReachabilityResult& OutResult) const
+{
+	if (!Units.IsValidIndex(UnitIndex) || !Units[UnitIndex].IsInBattle())
+	{
+		OutResult.Reset();
+		return;
+	}
+
+	FTileReachabilityQuery query;
+	MakeUnitQuery(UnitIndex, query);
+	Engine.Compute(Grid, query, OutResult);
+}
+
+bool FBattleState::MoveUnit(int32 UnitIndex, int32 TargetTile, FTileReachabilityEngine& Engine)
+{
+	if (!Units.IsValidIndex(UnitIndex) || !Units[UnitIndex].IsInBattle())
+	{
+		return false;
+	}
+
+	FBattleUnit& unit = Units[UnitIndex];
+	if (TargetTile == unit.Tile)
+	{
+		return true;
+	}
+	if (!Grid.IsValidTile(TargetTile) || TileUnits[TargetTile] != INDEX_NONE)
+	{
+		return false;	// allies can be passed through but not stopped on
+	}
+
+	FTileReachabilityQuery query;
+	MakeUnitQuery(UnitIndex, query);
+	query.MinActRange = query.MaxActRange = 0;	// only the movement matters here
+	query.bTargetsEnemies = query.bTargetsAllies = false;
+
+	FTileReachabilityResult result;
+	Engine.Compute(Grid, query, result);
+	const int32 distance = result.GetDistance(TargetTile);
+	if (distance == INDEX_NONE)
+	{
+		return false;
+	}
+
+	SetUnitTile(UnitIndex, TargetTile);
+	unit.RemainingSpaces = (uint8)FMath::Max((int32)unit.RemainingSpaces - distance, 0);
+	return true;
+}
+
+void FBattleState::CompleteUnitAction(int32 UnitIndex, bool bAllowMovement, uint8 RemainingMovement)
+{
+	FBattleUnit& unit = Units[UnitIndex];
+	unit.RemainingActions = unit.RemainingActions > 0 ? unit.RemainingActions - 1 : 0;
+	unit.RemainingSpaces = (!bAllowMovement && unit.RemainingActions == 0) ? 0 : RemainingMovement;
+}
+
+bool FBattleState::IsUnitDone(int32 UnitIndex) const
+{
+	const FBattleUnit& unit = Units[UnitIndex];
+	return unit.RemainingSpaces == 0 && unit.RemainingActions == 0;
+}
+
+void FBattleState::ActivateFaction(uint8 Faction)
+{
+	ActiveFaction = Faction;
+	for (FBattleUnit& unit : Units)
+	{
+		if (unit.IsInBattle() && unit.Faction == Faction)
+		{
+			unit.RemainingSpaces = unit.BaseMovementSpaces;
+			unit.RemainingActions = unit.BaseActions;
+		}
+	}
+}
+
+bool FBattleState::AdvancePhase()
+{
+	int32 unitCounts[BATTLE_FACTION_COUNT] = {};
+	for (const FBattleUnit& unit : Units)
+	{
+		if (unit.IsInBattle() && unit.Faction < BATTLE_FACTION_COUNT)
+		{
+			unitCounts[unit.Faction]++;
+		}
+	}
+
+	// Later factions this round first, then wrap around to a new round. Factions without units are skipped.
+	for (uint8 faction = ActiveFaction + 1; faction < BATTLE_FACTION_COUNT; faction++)
+	{
+		if (unitCounts[faction] > 0)
+		{
+			ActivateFaction(faction);
+			return true;
+		}
+	}
+	for (uint8 faction = BATTLE_FACTION_PLAYER; faction < BATTLE_FACTION_COUNT; faction++)
+	{
+		if (unitCounts[faction] > 0)
+		{
+			if (ActiveFaction != BATTLE_FACTION_NONE)
+			{
+				RoundNumber++;
+			}
+			ActivateFaction(faction);
+			return true;
+		}
+	}
+
+	ActiveFaction = BATTLE_FACTION_NONE;
+	return false;
+}
+
+uint32 FBattleState::GetHostileFactionMask(uint8 Faction)
+{
+	switch (Faction)
+	{
+	case (BATTLE_FACTION_PLAYER):
+	case (BATTLE_FACTION_PARTNER):
+		return 1u << BATTLE_FACTION_ENEMY;
+	case (BATTLE_FACTION_ENEMY):
+		return (1u << BATTLE_FACTION_PLAYER) | (1u << BATTLE_FACTION_PARTNER);
+	default:
+		return 0;
+	}
+}
+
+uint32 FBattleState::GetAlliedFactionMask(uint8 Faction)
+{
+	switch (Faction)
+	{
+	case (BATTLE_FACTION_PLAYER):
+	case (BATTLE_FACTION_PARTNER):
+		return (1u << BATTLE_FACTION_PLAYER) | (1u << BATTLE_FACTION_PARTNER);
+	case (BATTLE_FACTION_ENEMY):
+		return 1u << BATTLE_FACTION_ENEMY;
+	default:
+		return 0;
+	}
+}
+
+void FBattleState::SetUnitTile(int32 UnitIndex, int32 TileIndex)
+{
+	FBattleUnit& unit = Units[UnitIndex];
+	if (unit.Tile != INDEX_NONE)
+	{
+		TileUnits[unit.Tile] = INDEX_NONE;
+		Grid.SetOccupantFaction(unit.Tile, BATTLE_FACTION_NONE);
+	}
+
+	unit.Tile = TileIndex;
+	if (TileIndex != INDEX_NONE)
+	{
+		TileUnits[TileIndex] = UnitIndex;
+		Grid.SetOccupantFaction(TileIndex, unit.Faction);
+	}
+}
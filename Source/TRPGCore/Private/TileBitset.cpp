@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileBitset.h"
+
+void FTileBitset::Init(int32 NewTileCount)
+{
+	TileCount = FMath::Max(NewTileCount, 0);
+	Words.Init(0, (TileCount + 63) >> 6);
+}
+
+void FTileBitset::Reset()
+{
+	FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+}
+
+void FTileBitset::Union(const FTileBitset& Other)
+{
+	const int32 wordCount = FMath::Min(Words.Num(), Other.Words.Num());
+	uint64* RESTRICT words = Words.GetData();
+	const uint64* RESTRICT otherWords = Other.Words.GetData();
+	for (int32 wordIndex = 0; wordIndex < wordCount; wordIndex++)
+	{
+		words[wordIndex] |= otherWords[wordIndex];
+	}
+}
+
+void FTileBitset::Intersect(const FTileBitset& Other)
+{
+	const int32 wordCount = FMath::Min(Words.Num(), Other.Words.Num());
+	uint64* RESTRICT words = Words.GetData();
+	const uint64* RESTRICT otherWords = Other.Words.GetData();
+	for (int32 wordIndex = 0; wordIndex < wordCount; wordIndex++)
+	{
+		words[wordIndex] &= otherWords[wordIndex];
+	}
+	for (int32 wordIndex = wordCount; wordIndex < Words.Num(); wordIndex++)
+	{
+		words[wordIndex] = 0;	// Other has no tiles here
+	}
+}
+
+void FTileBitset::Difference(const FTileBitset& Other)
+{
+	const int32 wordCount = FMath::Min(Words.Num(), Other.Words.Num());
+	uint64* RESTRICT words = Words.GetData();
+	const uint64* RESTRICT otherWords = Other.Words.GetData();
+	for (int32 wordIndex = 0; wordIndex < wordCount; wordIndex++)
+	{
+		words[wordIndex] &= ~otherWords[wordIndex];
+	}
+}
+
+void FTileBitset::Difference(const FTileBitset& A, const FTileBitset& B, FTileBitset& OutResult)
+{
+	OutResult = A;
+	OutResult.Difference(B);
+}
+
+int32 FTileBitset::CountSetBits() const
+{
+	int32 count = 0;
+	for (uint64 word : Words)
+	{
+		count += (int32)FMath::CountBits(word);
+	}
+	return count;
+}
+
+bool FTileBitset::IsEmpty() const
+{
+	uint64 anyBits = 0;
+	for (uint64 word : Words)
+	{
+		anyBits |= word;
+	}
+	return anyBits == 0;
+}
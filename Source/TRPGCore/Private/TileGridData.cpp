@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileGridData.h"
+
+FArchive& operator<<(FArchive& Ar, FTileGraphRecord& Record)
+{
+	Ar << Record.Coord;
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		Ar << Record.Neighbors[dir];
+	}
+	Ar << Record.TerrainType;
+	Ar.Serialize(Record.Padding, sizeof(Record.Padding));	// same size either way, so BulkSerialize and per-record serialization agree
+	return Ar;
+}
+
+void FTileGridData::Reset()
+{
+	Coords.Reset();
+	TerrainTypes.Reset();
+	OccupantFactions.Reset();
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		Neighbors[dir].Reset();
+	}
+
+	GridMin = FIntPoint::ZeroValue;
+	GridSize = FIntPoint::ZeroValue;
+	CellFirstTile.Reset();
+	NextTileInCell.Reset();
+	for (int32 faction = 0; faction < OCCUPANT_FACTION_COUNT; faction++)
+	{
+		FactionCells[faction].Init(GridSize);
+	}
+}
+
+int32 FTileGridData::AddTile(const FIntVector& Coord, uint8 TerrainType)
+{
+	const int32 tileIndex = Coords.Add(Coord);
+	TerrainTypes.Add(TerrainType);
+	OccupantFactions.Add(0);
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		Neighbors[dir].Add(INDEX_NONE);
+	}
+	return tileIndex;
+}
+
+void FTileGridData::BuildCellLookup()
+{
+	if (Num() == 0)
+	{
+		GridMin = FIntPoint::ZeroValue;
+		GridSize = FIntPoint::ZeroValue;
+	}
+	else
+	{
+		FIntPoint gridMax(MIN_int32, MIN_int32);
+		GridMin = FIntPoint(MAX_int32, MAX_int32);
+		for (const FIntVector& coord : Coords)
+		{
+			GridMin = FIntPoint(FMath::Min(GridMin.X, coord.X), FMath::Min(GridMin.Y, coord.Y));
+			gridMax = FIntPoint(FMath::Max(gridMax.X, coord.X), FMath::Max(gridMax.Y, coord.Y));
+		}
+		GridSize = gridMax - GridMin + FIntPoint(1, 1);
+	}
+
+	CellFirstTile.Init(INDEX_NONE, GridSize.X * GridSize.Y);
+	NextTileInCell.Init(INDEX_NONE, Num());
+	for (int32 tileIndex = Num() - 1; tileIndex >= 0; tileIndex--)
+	{
+		// walk backwards so each cell chain is in increasing tile order
+		const int32 cell = GetCell(tileIndex);
+		NextTileInCell[tileIndex] = CellFirstTile[cell];
+		CellFirstTile[cell] = tileIndex;
+	}
+
+	for (int32 faction = 0; faction < OCCUPANT_FACTION_COUNT; faction++)
+	{
+		FactionCells[faction].Init(GridSize);
+	}
+	for (int32 tileIndex = 0; tileIndex < Num(); tileIndex++)
+	{
+		const uint8 faction = OccupantFactions[tileIndex];
+		if (faction != 0 && faction < OCCUPANT_FACTION_COUNT)
+		{
+			FactionCells[faction].Add(GetCell(tileIndex));
+		}
+	}
+}
+
+void FTileGridData::SetOccupantFaction(int32 TileIndex, uint8 Faction)
+{
+	const uint8 previousFaction = OccupantFactions[TileIndex];
+	if (previousFaction == Faction)
+	{
+		return;
+	}
+	OccupantFactions[TileIndex] = Faction;
+
+	if (CellFirstTile.IsEmpty())
+	{
+		return;	// cell lookup not built yet - BuildCellLookup() fills the masks
+	}
+
+	const int32 cell = GetCell(TileIndex);
+	if (previousFaction != 0 && previousFaction < OCCUPANT_FACTION_COUNT)
+	{
+		// another layer of the same cell may still hold a unit of the previous faction
+		bool cellHasFaction = false;
+		for (int32 tile = CellFirstTile[cell]; tile != INDEX_NONE; tile = NextTileInCell[tile])
+		{
+			cellHasFaction |= OccupantFactions[tile] == previousFaction;
+		}
+		if (!cellHasFaction)
+		{
+			FactionCells[previousFaction].Remove(cell);
+		}
+	}
+	if (Faction != 0 && Faction < OCCUPANT_FACTION_COUNT)
+	{
+		FactionCells[Faction].Add(cell);
+	}
+}
+
+void FTileGridData::FindOccupiedTilesInRange(int32 SourceTile, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<int32>& OutTiles) const
+{
+	ForEachOccupiedTileInRange(SourceTile, MinRange, MaxRange, FactionMask, [&OutTiles](int32 TileIndex)
+		{
+			OutTiles.Add(TileIndex);
+		});
+}
+
+void FTileGridData::FindOccupiedTilesInRange(TConstArrayView<int32> SourceTiles, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<int32>& OutTiles) const
+{
+	if (CellFirstTile.IsEmpty())
+	{
+		return;
+	}
+
+	FTileRowMask sourceCells, rangeCells;
+	sourceCells.Init(GridSize);
+	for (int32 sourceTile : SourceTiles)
+	{
+		if (IsValidTile(sourceTile))
+		{
+			sourceCells.Add(GetCell(sourceTile));
+		}
+	}
+	FTileRowMask::DilateAnnulus(sourceCells, MinRange, MaxRange, rangeCells);
+
+	for (int32 faction = 1; faction < OCCUPANT_FACTION_COUNT; faction++)
+	{
+		if (!(FactionMask & (1u << faction)))
+		{
+			continue;
+		}
+
+		FTileRowMask::ForEachSetBitInBoth(rangeCells, FactionCells[faction], [&](int32 Cell)
+			{
+				for (int32 tile = CellFirstTile[Cell]; tile != INDEX_NONE; tile = NextTileInCell[tile])
+				{
+					if (OccupantFactions[tile] == faction)
+					{
+						OutTiles.Add(tile);
+					}
+				}
+			});
+	}
+}
+
+bool FTileGridData::GetAreAdjacent(int32 TileA, int32 TileB, ETileNeighbor& DirectionFromA) const
+{
+	if (!IsValidTile(TileA) || !IsValidTile(TileB))
+	{
+		return false;
+	}
+
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		if (Neighbors[dir][TileA] == TileB)
+		{
+			DirectionFromA = (ETileNeighbor)dir;
+			return true;
+		}
+	}
+	return false;
+}
+
+ETileNeighbor FTileGridData::GetOppositeNeighbor(ETileNeighbor Direction)
+{
+	switch (Direction)
+	{
+	case (NEIGHBOR_NORTH):
+		return NEIGHBOR_SOUTH;
+	case (NEIGHBOR_WEST):
+		return NEIGHBOR_EAST;
+	case (NEIGHBOR_EAST):
+		return NEIGHBOR_WEST;
+	case (NEIGHBOR_SOUTH):
+		return NEIGHBOR_NORTH;
+	default:
+		return NEIGHBOR_COUNT;
+	}
+}
+
+void FTileGridData::ExportRecords(TArray<FTileGraphRecord>& OutRecords) const
+{
+	OutRecords.SetNum(Num());
+	for (int32 tileIndex = 0; tileIndex < Num(); tileIndex++)
+	{
+		FTileGraphRecord& record = OutRecords[tileIndex];
+		record.Coord = Coords[tileIndex];
+		record.TerrainType = TerrainTypes[tileIndex];
+		for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+		{
+			record.Neighbors[dir] = Neighbors[dir][tileIndex];
+		}
+	}
+}
+
+void FTileGridData::ImportRecords(const TArray<FTileGraphRecord>& Records)
+{
+	const int32 tileCount = Records.Num();
+	Coords.SetNumUninitialized(tileCount);
+	TerrainTypes.SetNumUninitialized(tileCount);
+	OccupantFactions.SetNumZeroed(tileCount);
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		Neighbors[dir].SetNumUninitialized(tileCount);
+	}
+
+	for (int32 tileIndex = 0; tileIndex < tileCount; tileIndex++)
+	{
+		const FTileGraphRecord& record = Records[tileIndex];
+		Coords[tileIndex] = record.Coord;
+		TerrainTypes[tileIndex] = record.TerrainType;
+		for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+		{
+			Neighbors[dir][tileIndex] = record.Neighbors[dir];
+		}
+	}
+
+	BuildCellLookup();
+}
@@ -0,0 +1,387 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TilePathPlanner.h"
+
+bool FTilePathPlanner::IsTileAllowed(const FTilePathQuery& Query, int32 TileIndex) const
+{
+	if (Query.AllowedTiles && !Query.AllowedTiles->Contains(TileIndex))
+	{
+		return false;
+	}
+	return !Query.ExcludedTiles || !Query.ExcludedTiles->Contains(TileIndex);
+}
+
+int32 FTilePathPlanner::GetHeuristic(const FTileGridData& Grid, int32 TileIndex, int32 GoalTile, int32 MinMoveCost) const
+{
+	const FIntVector& a = Grid.Coords[TileIndex];
+	const FIntVector& b = Grid.Coords[GoalTile];
+	return (FMath::Abs(a.X - b.X) + FMath::Abs(a.Y - b.Y)) * MinMoveCost;
+}
+
+bool FTilePathPlanner::FindPath(const FTileGridData& Grid, const FTilePathQuery& Query, TArray<int32>& OutPath, int32& OutCost)
+{
+	OutPath.Reset();
+	OutCost = 0;
+
+	if (!Grid.IsValidTile(Query.FromTile) || !Grid.IsValidTile(Query.ToTile) || !Query.HasMoveCosts(Grid))
+	{
+		return false;
+	}
+	if (Query.FromTile == Query.ToTile)
+	{
+		return true;
+	}
+	if (!IsTileAllowed(Query, Query.ToTile))
+	{
+		return false;
+	}
+
+	const int32 moveBudget = FMath::Clamp(Query.MoveBudget, 0, (int32)MAX_uint8);
+
+	int32 minMoveCost = Query.MoveCosts.Num() >= 256 ? 255 : 0;	// without the terrain table the heuristic falls back to 0 and the search to Dijkstra
+	for (uint8 moveCost : Query.MoveCosts)
+	{
+		minMoveCost = FMath::Min(minMoveCost, (int32)moveCost);
+	}
+
+	PrepareScratch(Grid.Num(), moveBudget);
+
+	// Search backwards from the target. RemainingCosts[Tile] is the movement spent walking from Tile to the target.
+	const int32 startEstimate = GetHeuristic(Grid, Query.ToTile, Query.FromTile, minMoveCost);
+	if (startEstimate > moveBudget)
+	{
+		return false;	// too far even on the cheapest terrain
+	}
+
+	Stamps[Query.ToTile] = Stamp;
+	RemainingCosts[Query.ToTile] = 0;
+	Buckets[startEstimate].Add(Query.ToTile);
+
+	bool foundStart = false;
+	for (int32 estimate = startEstimate; estimate <= moveBudget && !foundStart; estimate++)
+	{
+		TArray<int32>& bucket = Buckets[estimate];
+		for (int32 bucketPos = 0; bucketPos < bucket.Num(); bucketPos++)
+		{
+			const int32 tileIndex = bucket[bucketPos];
+			const int32 remainingCost = RemainingCosts[tileIndex];
+			if (remainingCost + GetHeuristic(Grid, tileIndex, Query.FromTile, minMoveCost) != estimate)
+			{
+				continue;	// stale entry
+			}
+			if (tileIndex == Query.FromTile)
+			{
+				foundStart = true;
+				break;
+			}
+
+			// Stepping from the neighbor onto this tile costs this tile's move cost
+			const int32 stepCost = Query.GetTileCost(Grid, tileIndex);
+			if (stepCost == 255)
+			{
+				continue;
+			}
+
+			for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+			{
+				const int32 neighborIndex = Grid.GetNeighbor(tileIndex, (ETileNeighbor)dir);
+				if (neighborIndex == INDEX_NONE || (neighborIndex != Query.FromTile && !IsTileAllowed(Query, neighborIndex)))
+				{
+					continue;
+				}
+
+				const int32 newCost = remainingCost + stepCost;
+				const int32 newEstimate = newCost + GetHeuristic(Grid, neighborIndex, Query.FromTile, minMoveCost);
+				if (newEstimate > moveBudget)
+				{
+					continue;
+				}
+
+				if (Stamps[neighborIndex] != Stamp || newCost < RemainingCosts[neighborIndex])
+				{
+					Stamps[neighborIndex] = Stamp;
+					RemainingCosts[neighborIndex] = (uint16)newCost;
+					Buckets[newEstimate].Add(neighborIndex);
+				}
+			}
+		}
+	}
+
+	if (!foundStart)
+	{
+		return false;
+	}
+
+	OutCost = RemainingCosts[Query.FromTile];
+	return WalkCheapestPath(Grid, Query, Query.FromTile, OutPath);
+}
+
+bool FTilePathPlanner::FindPathKeepingPrefix(const FTileGridData& Grid, const FTilePathQuery& Query, TConstArrayView<int32> Path, int32& OutPrefixLength, TArray<int32>& OutDetour)
+{
+	OutPrefixLength = 0;
+	OutDetour.Reset();
+
+	if (Path.IsEmpty() || !Grid.IsValidTile(Query.ToTile) || !Query.HasMoveCosts(Grid))
+	{
+		return false;
+	}
+	for (int32 tileIndex : Path)
+	{
+		if (!Grid.IsValidTile(tileIndex))
+		{
+			return false;
+		}
+	}
+
+	const int32 pathLength = Path.Num();
+	const int32 moveBudget = FMath::Clamp(Query.MoveBudget, 0, (int32)MAX_uint8);
+
+	PrepareScratch(Grid.Num(), moveBudget);
+	if (TileLevels.Num() != Grid.Num())
+	{
+		TileLevels.SetNumUninitialized(Grid.Num());
+		FirstLabels.SetNumUninitialized(Grid.Num());
+		PathIndices.Init(INDEX_NONE, Grid.Num());
+	}
+
+	PrefixCosts.SetNumUninitialized(pathLength);
+	PrefixCosts[0] = 0;		// the first tile is where the unit starts
+	PathIndices[Path[0]] = 0;
+	for (int32 i = 1; i < pathLength; i++)
+	{
+		PrefixCosts[i] = PrefixCosts[i - 1] + Query.GetTileCost(Grid, Path[i]);
+		PathIndices[Path[i]] = i;
+	}
+
+	// Search backwards from the target in cost order. A label reaching path tile i with level i is a detour that keeps Path[0..i]
+	// without crossing it - the longest such prefix that fits in the budget wins, and the cheapest detour for it is settled first.
+	Labels.Reset();
+	int32 bestSplit = INDEX_NONE;
+	int32 bestLabel = INDEX_NONE;
+
+	const int32 targetLevel = PathIndices[Query.ToTile] != INDEX_NONE ? PathIndices[Query.ToTile] : pathLength;
+	if (targetLevel != pathLength || !Query.AllowedTiles || Query.AllowedTiles->Contains(Query.ToTile))
+	{
+		Labels.Add({ Query.ToTile, 0, targetLevel, INDEX_NONE });
+		Buckets[0].Add(0);
+	}
+
+	for (int32 cost = 0; cost <= moveBudget && bestSplit < pathLength - 1; cost++)
+	{
+		if (cost > moveBudget - PrefixCosts[bestSplit + 1])
+		{
+			break;	// no longer prefix can fit a detour this expensive
+		}
+
+		TArray<int32>& bucket = Buckets[cost];
+		for (int32 bucketPos = 0; bucketPos < bucket.Num() && bestSplit < pathLength - 1; bucketPos++)
+		{
+			const int32 labelIndex = bucket[bucketPos];
+			const int32 tileIndex = Labels[labelIndex].Tile;
+			const int32 level = Labels[labelIndex].Level;
+			if (Stamps[tileIndex] == Stamp && TileLevels[tileIndex] >= level)
+			{
+				continue;	// a route at most as expensive already serves these prefixes
+			}
+			if (Stamps[tileIndex] != Stamp)
+			{
+				Stamps[tileIndex] = Stamp;
+				FirstLabels[tileIndex] = INDEX_NONE;
+			}
+			TileLevels[tileIndex] = level;
+			Labels[labelIndex].NextOnTile = FirstLabels[tileIndex];
+			FirstLabels[tileIndex] = labelIndex;
+
+			const int32 pathIndex = PathIndices[tileIndex];
+			if (pathIndex == level && pathIndex > bestSplit && PrefixCosts[pathIndex] + cost <= moveBudget)
+			{
+				bestSplit = pathIndex;
+				bestLabel = labelIndex;
+			}
+			if (level <= bestSplit)
+			{
+				continue;	// can only lead to shorter prefixes
+			}
+
+			// Stepping from the neighbor onto this tile costs this tile's move cost
+			const int32 stepCost = Query.GetTileCost(Grid, tileIndex);
+			if (stepCost == 255)
+			{
+				continue;
+			}
+			const int32 newCost = cost + stepCost;
+			if (newCost > moveBudget - PrefixCosts[bestSplit + 1])
+			{
+				continue;
+			}
+
+			for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+			{
+				const int32 neighborIndex = Grid.GetNeighbor(tileIndex, (ETileNeighbor)dir);
+				if (neighborIndex == INDEX_NONE)
+				{
+					continue;
+				}
+
+				// Path tiles were navigable when drawn. Passing through one lowers the route's level to its index.
+				const int32 neighborPathIndex = PathIndices[neighborIndex];
+				if (neighborPathIndex == INDEX_NONE && Query.AllowedTiles && !Query.AllowedTiles->Contains(neighborIndex))
+				{
+					continue;
+				}
+				const int32 newLevel = neighborPathIndex == INDEX_NONE ? level : FMath::Min(level, neighborPathIndex);
+				if (newLevel <= bestSplit || (Stamps[neighborIndex] == Stamp && TileLevels[neighborIndex] >= newLevel))
+				{
+					continue;
+				}
+
+				Buckets[newCost].Add(Labels.Add({ neighborIndex, newCost, newLevel, INDEX_NONE }));
+			}
+		}
+	}
+
+	bool foundPath = bestSplit != INDEX_NONE;
+	if (foundPath)
+	{
+		// Walk forwards from the split, taking the first step in DirectionPriority that stays on a cheapest route valid for this prefix
+		OutPrefixLength = bestSplit + 1;
+		int32 currentTile = Path[bestSplit];
+		int32 currentCost = Labels[bestLabel].Cost;
+		while (currentTile != Query.ToTile)
+		{
+			int32 nextTile = INDEX_NONE;
+			for (ETileNeighbor dir : Query.DirectionPriority)
+			{
+				const int32 neighborIndex = Grid.GetNeighbor(currentTile, dir);
+				if (neighborIndex == INDEX_NONE || Stamps[neighborIndex] != Stamp || neighborIndex == Path[bestSplit] || OutDetour.Contains(neighborIndex))
+				{
+					continue;
+				}
+
+				const int32 stepCost = Query.GetTileCost(Grid, neighborIndex);
+				if (stepCost != 255 && FindPrefixLabel(neighborIndex, currentCost - stepCost, bestSplit) != INDEX_NONE)
+				{
+					nextTile = neighborIndex;
+					break;
+				}
+			}
+
+			if (nextTile == INDEX_NONE)
+			{
+				OutDetour.Reset();
+				OutPrefixLength = 0;
+				foundPath = false;	// only possible with inconsistent data - the neighbor links are not symmetric
+				break;
+			}
+
+			OutDetour.Add(nextTile);
+			currentCost -= Query.GetTileCost(Grid, nextTile);
+			currentTile = nextTile;
+		}
+	}
+
+	for (int32 tileIndex : Path)
+	{
+		PathIndices[tileIndex] = INDEX_NONE;
+	}
+	return foundPath;
+}
+
+int32 FTilePathPlanner::FindPrefixLabel(int32 TileIndex, int32 Cost, int32 MinLevel) const
+{
+	for (int32 labelIndex = FirstLabels[TileIndex]; labelIndex != INDEX_NONE; labelIndex = Labels[labelIndex].NextOnTile)
+	{
+		if (Labels[labelIndex].Cost == Cost && Labels[labelIndex].Level >= MinLevel)
+		{
+			return labelIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void FTilePathPlanner::PrepareScratch(int32 TileCount, int32 MoveBudget)
+{
+	if (Stamps.Num() != TileCount)
+	{
+		Stamps.Init(0, TileCount);
+		RemainingCosts.SetNumUninitialized(TileCount);
+		Stamp = 0;
+	}
+	if (++Stamp == 0)
+	{
+		FMemory::Memzero(Stamps.GetData(), Stamps.Num() * sizeof(uint32));
+		Stamp = 1;
+	}
+
+	if (Buckets.Num() < MoveBudget + 1)
+	{
+		Buckets.SetNum(MoveBudget + 1);
+	}
+	for (int32 bucket = 0; bucket <= MoveBudget; bucket++)
+	{
+		Buckets[bucket].Reset();
+	}
+}
+
+bool FTilePathPlanner::WalkCheapestPath(const FTileGridData& Grid, const FTilePathQuery& Query, int32 FromTile, TArray<int32>& OutPath) const
+{
+	// Walk forwards. Every explored tile's cost is reached through the tile that set it, so a cheapest next step always exists.
+	OutPath.Reset();
+	int32 currentTile = FromTile;
+	int32 currentCost = RemainingCosts[FromTile];
+	while (currentTile != Query.ToTile)
+	{
+		int32 nextTile = INDEX_NONE;
+		for (ETileNeighbor dir : Query.DirectionPriority)
+		{
+			const int32 neighborIndex = Grid.GetNeighbor(currentTile, dir);
+			if (neighborIndex == INDEX_NONE || Stamps[neighborIndex] != Stamp || OutPath.Contains(neighborIndex))
+			{
+				continue;
+			}
+			if (neighborIndex != Query.ToTile && !IsTileAllowed(Query, neighborIndex))
+			{
+				continue;
+			}
+
+			const int32 stepCost = Query.GetTileCost(Grid, neighborIndex);
+			if (stepCost != 255 && RemainingCosts[neighborIndex] + stepCost == currentCost)
+			{
+				nextTile = neighborIndex;
+				break;
+			}
+		}
+
+		if (nextTile == INDEX_NONE)
+		{
+			OutPath.Reset();
+			return false;	// only possible with inconsistent data - the neighbor links are not symmetric
+		}
+
+		OutPath.Add(nextTile);
+		currentCost = RemainingCosts[nextTile];
+		currentTile = nextTile;
+	}
+	return true;
+}
+
+void FTilePathPlanner::GetCameraDirectionPriority(bool bCameraFacesNorthOrSouth, ETileNeighbor (&OutPriority)[NEIGHBOR_COUNT])
+{
+	if (bCameraFacesNorthOrSouth)
+	{
+		// priority is west/east/south/north
+		OutPriority[0] = NEIGHBOR_WEST;
+		OutPriority[1] = NEIGHBOR_EAST;
+		OutPriority[2] = NEIGHBOR_SOUTH;
+		OutPriority[3] = NEIGHBOR_NORTH;
+	}
+	else
+	{
+		// priority is north/south/east/west
+		OutPriority[0] = NEIGHBOR_NORTH;
+		OutPriority[1] = NEIGHBOR_SOUTH;
+		OutPriority[2] = NEIGHBOR_EAST;
+		OutPriority[3] = NEIGHBOR_WEST;
+	}
+}
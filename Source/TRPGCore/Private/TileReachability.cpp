@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileReachability.h"
+#include "Algo/Reverse.h"
+
+void FTileReachabilityResult::Reset()
+{
+	NavigableTiles.Reset();
+	Distances.Reset();
+	Predecessors.Reset();
+	AttackableTiles.Reset();
+	InteractableTiles.Reset();
+	RangeTiles.Reset();
+	TileSlots.Reset();
+}
+
+int32 FTileReachabilityResult::GetDistance(int32 TileIndex) const
+{
+	const int32* slot = TileSlots.Find(TileIndex);
+	return slot ? Distances[*slot] : INDEX_NONE;
+}
+
+int32 FTileReachabilityResult::GetPredecessor(int32 TileIndex) const
+{
+	const int32* slot = TileSlots.Find(TileIndex);
+	return slot ? Predecessors[*slot] : INDEX_NONE;
+}
+
+void FTileReachabilityResult::GetPathTo(int32 TileIndex, TArray<int32>& OutPath) const
+{
+	OutPath.Reset();
+	if (!IsNavigable(TileIndex))
+	{
+		return;
+	}
+
+	for (int32 tile = TileIndex; tile != INDEX_NONE; tile = GetPredecessor(tile))
+	{
+		OutPath.Add(tile);
+	}
+	Algo::Reverse(OutPath);
+}
+
+void FTileReachabilityEngine::PrepareScratch(int32 TileCount)
+{
+	if (MoveStamps.Num() != TileCount)
+	{
+		MoveStamps.Init(0, TileCount);
+		MoveDistances.SetNumUninitialized(TileCount);
+		MovePredecessors.SetNumUninitialized(TileCount);
+		MoveStamp = 0;
+	}
+
+	if (++MoveStamp == 0)
+	{
+		// stamp wrapped - old stamps could match again
+		FMemory::Memzero(MoveStamps.GetData(), MoveStamps.Num() * sizeof(uint32));
+		MoveStamp = 1;
+	}
+}
+
+void FTileReachabilityEngine::Compute(const FTileGridData& Grid, const FTileReachabilityQuery& Query, FTileReachabilityResult& OutResult)
+{
+	OutResult.Reset();
+
+	if (!Grid.IsValidTile(Query.StartTile))
+	{
+		return;
+	}
+
+	PrepareScratch(Grid.Num());
+
+	const int32 moveBudget = FMath::Clamp(Query.MoveBudget, 0, (int32)MAX_uint8);
+	const bool hasMoveCosts = Query.HasMoveCosts(Grid);	// without a cost table the unit can only stay where it is
+
+	if (Buckets.Num() < moveBudget + 1)
+	{
+		Buckets.SetNum(moveBudget + 1);
+	}
+	for (int32 bucket = 0; bucket <= moveBudget; bucket++)
+	{
+		Buckets[bucket].Reset();
+	}
+
+	MoveStamps[Query.StartTile] = MoveStamp;
+	MoveDistances[Query.StartTile] = 0;
+	MovePredecessors[Query.StartTile] = INDEX_NONE;
+	Buckets[0].Add(Query.StartTile);
+
+	// Pop buckets in distance order. A tile can sit in several buckets after its distance improves - only the entry matching its final distance settles it.
+	for (int32 distance = 0; distance <= moveBudget; distance++)
+	{
+		TArray<int32>& bucket = Buckets[distance];
+		for (int32 bucketPos = 0; bucketPos < bucket.Num(); bucketPos++)	// zero-cost terrain can append to the bucket being read
+		{
+			const int32 tileIndex = bucket[bucketPos];
+			if (MoveDistances[tileIndex] != distance)
+			{
+				continue;	// stale entry
+			}
+
+			OutResult.TileSlots.Add(tileIndex, OutResult.NavigableTiles.Num());
+			OutResult.NavigableTiles.Add(tileIndex);
+			OutResult.Distances.Add((uint16)distance);
+			OutResult.Predecessors.Add(MovePredecessors[tileIndex]);
+
+			if (!hasMoveCosts)
+			{
+				continue;
+			}
+
+			for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+			{
+				const int32 neighborIndex = Grid.GetNeighbor(tileIndex, (ETileNeighbor)dir);
+				if (neighborIndex == INDEX_NONE)
+				{
+					continue;
+				}
+
+				const uint8 moveCost = Query.GetTileCost(Grid, neighborIndex);
+				if (moveCost == BLOCKED_MOVE_COST || (Query.HostileFactions & (1u << Grid.OccupantFactions[neighborIndex])))
+				{
+					continue;	// impassable terrain or a hostile unit in the way
+				}
+
+				const int32 newDistance = distance + moveCost;
+				if (newDistance > moveBudget)
+				{
+					continue;
+				}
+
+				if (MoveStamps[neighborIndex] != MoveStamp || newDistance < MoveDistances[neighborIndex])
+				{
+					MoveStamps[neighborIndex] = MoveStamp;
+					MoveDistances[neighborIndex] = (uint16)newDistance;
+					MovePredecessors[neighborIndex] = tileIndex;
+					Buckets[newDistance].Add(neighborIndex);
+				}
+			}
+		}
+	}
+
+	if ((Query.bTargetsEnemies || Query.bTargetsAllies || Query.bCollectRangeTiles) && Query.MaxActRange > 0)
+	{
+		ComputeActionTargets(Grid, Query, OutResult);
+	}
+}
+
+bool FTileReachabilityEngine::IsStandingTile(const FTileGridData& Grid, const FTileReachabilityQuery& Query, int32 TileIndex) const
+{
+	return MoveStamps[TileIndex] == MoveStamp && (TileIndex == Query.StartTile || Grid.OccupantFactions[TileIndex] == 0);
+}
+
+void FTileReachabilityEngine::ComputeActionTargets(const FTileGridData& Grid, const FTileReachabilityQuery& Query, FTileReachabilityResult& OutResult)
+{
+	if (Grid.CellFirstTile.IsEmpty())
+	{
+		return;	// no cell lookup for this grid
+	}
+
+	StandingCells.Init(Grid.GridSize);
+	for (int32 tileIndex : OutResult.NavigableTiles)
+	{
+		if (IsStandingTile(Grid, Query, tileIndex))
+		{
+			StandingCells.Add(Grid.GetCell(tileIndex));
+		}
+	}
+
+	FTileRowMask::DilateAnnulus(StandingCells, Query.MinActRange, Query.MaxActRange, RangeCells);
+
+	if (Query.bTargetsEnemies)
+	{
+		CollectTargetsInRange(Grid, Query, Query.HostileFactions, OutResult.AttackableTiles);
+	}
+	if (Query.bTargetsAllies)
+	{
+		CollectTargetsInRange(Grid, Query, Query.AlliedFactions, OutResult.InteractableTiles);
+	}
+	if (Query.bCollectRangeTiles)
+	{
+		FTileRowMask::ForEachSetBitInBoth(RangeCells, RangeCells, [&](int32 Cell)
+			{
+				for (int32 tile = Grid.CellFirstTile[Cell]; tile != INDEX_NONE; tile = Grid.NextTileInCell[tile])
+				{
+					OutResult.RangeTiles.Add(tile);
+				}
+			});
+	}
+}
+
+void FTileReachabilityEngine::CollectTargetsInRange(const FTileGridData& Grid, const FTileReachabilityQuery& Query, uint32 TargetFactions, TArray<int32>& OutTargets) const
+{
+	for (int32 faction = 1; faction < OCCUPANT_FACTION_COUNT; faction++)
+	{
+		if (!(TargetFactions & (1u << faction)))
+		{
+			continue;
+		}
+
+		FTileRowMask::ForEachSetBitInBoth(RangeCells, Grid.FactionCells[faction], [&](int32 Cell)
+			{
+				// a cell can stack several layers - only the tiles holding the faction are targets
+				for (int32 tile = Grid.CellFirstTile[Cell]; tile != INDEX_NONE; tile = Grid.NextTileInCell[tile])
+				{
+					if (tile != Query.StartTile && Grid.OccupantFactions[tile] == faction)
+					{
+						OutTargets.Add(tile);
+					}
+				}
+			});
+	}
+}
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileRowMask.h"
+
+void FTileRowMask::Init(const FIntPoint& InSize)
+{
+	Size = FIntPoint(FMath::Max(InSize.X, 0), FMath::Max(InSize.Y, 0));
+	WordsPerRow = (Size.Y + 63) >> 6;
+	Words.Init(0, Size.X * WordsPerRow);
+}
+
+void FTileRowMask::Reset()
+{
+	FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+}
+
+void FTileRowMask::OrShiftedRow(const uint64* SourceRow, uint64* DestRow, int32 WordCount, int32 Shift)
+{
+	if (Shift >= 0)
+	{
+		const int32 wordShift = Shift >> 6;
+		const int32 bitShift = Shift & 63;
+		for (int32 wordIndex = wordShift; wordIndex < WordCount; wordIndex++)
+		{
+			const int32 sourceIndex = wordIndex - wordShift;
+			uint64 word = SourceRow[sourceIndex] << bitShift;
+			if (bitShift && sourceIndex > 0)
+			{
+				word |= SourceRow[sourceIndex - 1] >> (64 - bitShift);	// bits carried over from the lower word
+			}
+			DestRow[wordIndex] |= word;
+		}
+	}
+	else
+	{
+		const int32 wordShift = (-Shift) >> 6;
+		const int32 bitShift = (-Shift) & 63;
+		for (int32 wordIndex = 0; wordIndex + wordShift < WordCount; wordIndex++)
+		{
+			const int32 sourceIndex = wordIndex + wordShift;
+			uint64 word = SourceRow[sourceIndex] >> bitShift;
+			if (bitShift && sourceIndex + 1 < WordCount)
+			{
+				word |= SourceRow[sourceIndex + 1] << (64 - bitShift);	// bits carried over from the higher word
+			}
+			DestRow[wordIndex] |= word;
+		}
+	}
+}
+
+void FTileRowMask::ClearRowTails()
+{
+	const int32 tailBits = Size.Y & 63;
+	if (tailBits == 0)
+	{
+		return;
+	}
+
+	const uint64 tailMask = (1ull << tailBits) - 1;
+	for (int32 row = 0; row < Size.X; row++)
+	{
+		GetRow(row)[WordsPerRow - 1] &= tailMask;
+	}
+}
+
+void FTileRowMask::DilateAnnulus(const FTileRowMask& Source, int32 MinRange, int32 MaxRange, FTileRowMask& OutResult)
+{
+	OutResult.Init(Source.Size);
+
+	MinRange = FMath::Max(MinRange, 0);
+	if (MaxRange < MinRange)
+	{
+		return;
+	}
+
+	for (int32 sourceRow = 0; sourceRow < Source.Size.X; sourceRow++)
+	{
+		const uint64* sourceWords = Source.GetRow(sourceRow);
+
+		uint64 anyBits = 0;
+		for (int32 wordIndex = 0; wordIndex < Source.WordsPerRow; wordIndex++)
+		{
+			anyBits |= sourceWords[wordIndex];
+		}
+		if (anyBits == 0)
+		{
+			continue;	// nothing to spread from this row
+		}
+
+		// A row dx away may be shifted along Y by any offset with MinRange <= |dx| + |dy| <= MaxRange
+		const int32 firstRow = FMath::Max(sourceRow - MaxRange, 0);
+		const int32 lastRow = FMath::Min(sourceRow + MaxRange, Source.Size.X - 1);
+		for (int32 destRow = firstRow; destRow <= lastRow; destRow++)
+		{
+			const int32 rowDistance = FMath::Abs(destRow - sourceRow);
+			const int32 minShift = FMath::Max(MinRange - rowDistance, 0);
+			const int32 maxShift = FMath::Min(MaxRange - rowDistance, Source.Size.Y);
+
+			uint64* destWords = OutResult.GetRow(destRow);
+			for (int32 shift = minShift; shift <= maxShift; shift++)
+			{
+				OrShiftedRow(sourceWords, destWords, Source.WordsPerRow, shift);
+				if (shift > 0)
+				{
+					OrShiftedRow(sourceWords, destWords, Source.WordsPerRow, -shift);
+				}
+			}
+		}
+	}
+
+	OutResult.ClearRowTails();
+}
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileSpatialHashLinker.h"
+
+void FTileSpatialHashLinker::LinkTiles(TConstArrayView<FVector> Locations, TConstArrayView<float> Spacings, TConstArrayView<float> VerticalRanges, TArray<int32> (&OutNeighbors)[NEIGHBOR_COUNT])
+{
+	const int32 tileCount = Locations.Num();
+	for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+	{
+		OutNeighbors[dir].Init(INDEX_NONE, tileCount);
+	}
+
+	if (tileCount == 0)
+	{
+		return;
+	}
+
+	// Hash cells are as wide as the largest tile spacing so a probe tolerance box never spans more than two cells per axis.
+	// Z bands use the vertical range of the first tile. Candidates are always checked by distance, so mixed spacings still link.
+	float cellSize = 1.0f;
+	for (float spacing : Spacings)
+	{
+		cellSize = FMath::Max(cellSize, spacing);
+	}
+	const float bandHeight = FMath::Max(VerticalRanges[0], 1.0f);
+
+	auto getCell = [cellSize](float Coord)
+		{
+			return FMath::FloorToInt(Coord / cellSize);
+		};
+
+	// Bucket every tile. Buckets are singly linked lists through nextInBucket to avoid an array allocation per cell.
+	TMap<FIntVector, int32> bucketHeads;
+	bucketHeads.Reserve(tileCount);
+	TArray<int32> nextInBucket;
+	nextInBucket.Init(INDEX_NONE, tileCount);
+
+	for (int32 tileIndex = 0; tileIndex < tileCount; tileIndex++)
+	{
+		const FVector& loc = Locations[tileIndex];
+		const FIntVector key(getCell(loc.X), getCell(loc.Y), FMath::FloorToInt(loc.Z / bandHeight));
+		int32& head = bucketHeads.FindOrAdd(key, INDEX_NONE);
+		nextInBucket[tileIndex] = head;
+		head = tileIndex;
+	}
+
+	// Probe the cell at each neighbor position. A trace would run from (Z - range / 2) up to (Z + range / 2) and hit the lowest tile first.
+	for (int32 tileIndex = 0; tileIndex < tileCount; tileIndex++)
+	{
+		const FVector& loc = Locations[tileIndex];
+		const float spacing = Spacings[tileIndex];
+		const float halfRange = VerticalRanges[tileIndex] / 2;
+		const float tolerance = spacing / 2;
+		const int32 lowBand = FMath::FloorToInt((loc.Z - halfRange) / bandHeight);
+		const int32 highBand = FMath::FloorToInt((loc.Z + halfRange) / bandHeight);
+
+		for (int32 dir = 0; dir < NEIGHBOR_COUNT; dir++)
+		{
+			const FVector probeLoc = loc + GetNeighborOffset((ETileNeighbor)dir, spacing);
+			int32 bestTile = INDEX_NONE;
+			double bestZ = TNumericLimits<double>::Max();
+
+			// Only the cells overlapping the probe tolerance box can hold the neighbor - at most two per axis
+			const int32 minCellX = getCell(probeLoc.X - tolerance), maxCellX = getCell(probeLoc.X + tolerance);
+			const int32 minCellY = getCell(probeLoc.Y - tolerance), maxCellY = getCell(probeLoc.Y + tolerance);
+
+			for (int32 band = lowBand; band <= highBand; band++)
+			{
+				for (int32 cellX = minCellX; cellX <= maxCellX; cellX++)
+				{
+					for (int32 cellY = minCellY; cellY <= maxCellY; cellY++)
+					{
+						const int32* head = bucketHeads.Find(FIntVector(cellX, cellY, band));
+						for (int32 candidate = head ? *head : INDEX_NONE; candidate != INDEX_NONE; candidate = nextInBucket[candidate])
+						{
+							if (candidate == tileIndex)
+							{
+								continue;
+							}
+
+							const FVector& candidateLoc = Locations[candidate];
+							if (FMath::Abs(candidateLoc.X - probeLoc.X) > tolerance || FMath::Abs(candidateLoc.Y - probeLoc.Y) > tolerance
+								|| FMath::Abs(candidateLoc.Z - loc.Z) > halfRange)
+							{
+								continue;
+							}
+
+							if (candidateLoc.Z < bestZ)
+							{
+								bestTile = candidate;
+								bestZ = candidateLoc.Z;
+							}
+						}
+					}
+				}
+			}
+
+			OutNeighbors[dir][tileIndex] = bestTile;
+		}
+	}
+}
+
+FVector FTileSpatialHashLinker::GetNeighborOffset(ETileNeighbor Direction, float Spacing)
+{
+	switch (Direction)
+	{
+	case (NEIGHBOR_NORTH):
+		return FVector(Spacing, 0.0f, 0.0f);
+	case (NEIGHBOR_WEST):
+		return FVector(0.0f, -Spacing, 0.0f);
+	case (NEIGHBOR_EAST):
+		return FVector(0.0f, Spacing, 0.0f);
+	case (NEIGHBOR_SOUTH):
+		return FVector(-Spacing, 0.0f, 0.0f);
+	default:
+		return FVector::ZeroVector;
+	}
+}
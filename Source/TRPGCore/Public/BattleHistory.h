@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BattleState.h"
+
+#define BATTLE_HISTORY_PAGE_BYTES 1024	// Size of one page shared between snapshots - 64 units or 4 move cost tables
+
+// An array stored as fixed-size pages. Pages are never written once made, so any number of snapshots can point at the same one.
+struct TRPGCORE_API FBattlePageArray
+{
+	TArray<TSharedRef<const TArray<uint8>>>	Pages;
+	int32									NumBytes = 0;
+};
+
+// One battle snapshot - the parts of FBattleState that change during a battle
+struct FBattleSnapshot
+{
+	TSharedPtr<const FBattlePageArray>	Units;				// FBattleUnit bytes
+	TSharedPtr<const FBattlePageArray>	MoveCostTables;
+
+	uint8	ActiveFaction	= BATTLE_FACTION_NONE;
+	int32	RoundNumber		= 1;
+};
+
+// Copy-on-write history of a battle for turn rewind.
+// Each snapshot keeps the units and move cost tables as pages, and a page only gets new memory if its bytes differ from the same
+// page of the previous snapshot - an action that moves one unit adds one units page, and arrays it did not touch share the
+// previous snapshot's whole page list. The tile graph and terrain do not change during a battle and are kept once, from the
+// first snapshot, so a snapshot costs what changed rather than the map size. Reset() the history after a scripted terrain change.
+// Tile occupants are not stored: they follow from the units, and restoring rebuilds them from the units that moved.
+struct TRPGCORE_API FBattleHistory
+{
+public:
+
+	void Reset();
+
+	int32 TakeSnapshot(const FBattleState& State);	// Adds a snapshot of State and returns its index. A state on a different tile graph starts the history over. Terrain is not read after the first.
+
+	// Sets State to a snapshot. State keeps its arrays, terrain included, when it is on the history's tile graph, so only the units
+	// that moved touch the occupant data - restoring costs a copy of the pages rather than of the state. False if the index is invalid.
+	bool RestoreSnapshot(int32 SnapshotIndex, FBattleState& State) const;
+
+	void TruncateSnapshots(int32 NumSnapshots);		// Drops every snapshot from NumSnapshots on, e.g. the undone actions after a rewind
+
+	int32 Num() const { return Snapshots.Num(); }
+
+	const FBattleSnapshot& GetSnapshot(int32 SnapshotIndex) const { return Snapshots[SnapshotIndex]; }
+
+	int64 GetAllocatedSize() const;					// Bytes held by the tile graph and every distinct page
+
+protected:
+
+	// Pages Data, reusing each page of Previous whose bytes are unchanged. Returns Previous itself when nothing changed.
+	static TSharedPtr<const FBattlePageArray> WritePages(const void* Data, int32 NumBytes, const TSharedPtr<const FBattlePageArray>& Previous);
+
+	static void ReadPages(const FBattlePageArray& PageArray, void* OutData);
+
+protected:
+
+	FTileGridData			Grid;			// Tile graph and terrain shared by every snapshot. Occupants are left clear.
+
+	TArray<FBattleSnapshot>	Snapshots;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileGridData.h"
+#include "TileReachability.h"
+
+// Faction bytes of the battle core. Same values as EUnitFaction, which lives with the actors.
+enum EBattleFaction : uint8
+{
+	BATTLE_FACTION_NONE		= 0,
+	BATTLE_FACTION_PLAYER	= 1,
+	BATTLE_FACTION_PARTNER	= 2,
+	BATTLE_FACTION_ENEMY	= 3,
+	BATTLE_FACTION_NPC		= 4,
+	BATTLE_FACTION_COUNT	= 5
+};
+
+// One unit of a battle - the state AGameUnit keeps for the rules, without the actor
+struct FBattleUnit
+{
+	int32	Tile				= INDEX_NONE;	// Tile index the unit stands on. INDEX_NONE once removed from the battle.
+	uint8	Faction				= BATTLE_FACTION_NONE;
+	uint8	MoveClass			= 0;			// Index of the unit's move cost table in FBattleState::MoveCostTables
+
+	uint8	BaseMovementSpaces	= 0;			// Movement and actions restored at the start of the unit's phase
+	uint8	BaseActions			= 1;
+	uint8	RemainingSpaces		= 0;
+	uint8	RemainingActions	= 0;
+
+	uint8	MinActRange			= 0;			// Equipped weapon range
+	uint8	MaxActRange			= 0;
+	bool	bTargetsEnemies		= false;
+	bool	bTargetsAllies		= false;
+	uint8	Padding[2]			= { 0, 0 };		// Keeps the unit bytes deterministic - FBattleHistory compares them to share unchanged pages
+
+	bool IsInBattle() const { return Tile != INDEX_NONE; }
+};
+
+// Complete state of a battle as plain arrays - tiles, terrain, occupants, units and the phase loop.
+// Holds no UObjects, so it copies in one pass over a few arrays, steps without actors and can be searched on any thread,
+// e.g. cloned for AI lookahead. ACombatGameMode::CaptureBattleState() fills it from the actors; the actors remain the view.
+// Units keep their index for the whole battle - removed units stay in the array with Tile set to INDEX_NONE.
+struct TRPGCORE_API FBattleState
+{
+public:
+
+	FTileGridData		Grid;					// Tile graph, terrain and occupant factions
+
+	TArray<int32>		TileUnits;				// Unit index standing on each tile, or INDEX_NONE
+
+	TArray<FBattleUnit>	Units;
+
+	TArray<uint8>		MoveCostTables;			// 256 move costs per movement class, by terrain type byte
+
+	uint8				ActiveFaction	= BATTLE_FACTION_NONE;	// Faction whose phase it is
+	int32				RoundNumber		= 1;	// Increments each time the phase loop wraps back to its first faction
+
+public:
+
+	void Reset();
+
+	void InitTiles(const FTileGridData& InGrid);		// Copies the tile graph. Occupants are cleared - add units afterwards.
+
+	int32 AddMoveCostTable(TConstArrayView<uint8> MoveCosts);		// Adds a 256-entry cost table and returns its movement class
+
+	int32 AddUnit(const FBattleUnit& Unit);			// Places a unit on its tile and returns its index. INDEX_NONE if the tile is invalid or taken. A Tile of INDEX_NONE adds it as removed.
+
+	void ClearUnits();								// Takes every unit off the map and empties Units. The tile graph and terrain are kept.
+
+	void RemoveUnit(int32 UnitIndex);				// Takes a unit off the map (defeated). Its index stays valid.
+
+	int32 GetUnitOnTile(int32 TileIndex) const { return TileUnits.IsValidIndex(TileIndex) ? TileUnits[TileIndex] : INDEX_NONE; }
+
+	int32 CountUnits(uint8 Faction) const;			// Units of a faction still in the battle
+
+	// Rules - mirror ACombatGameMode, AGameUnit and ATileControlPawn
+
+	void MakeUnitQuery(int32 UnitIndex, FTileReachabilityQuery& OutQuery) const;	// Same query the pawn builds when the unit is selected
+
+	void ComputeReachability(int32 UnitIndex, FTileReachabilityEngine& Engine, FTileReachabilityResult& OutResult) const;
+
+	bool MoveUnit(int32 UnitIndex, int32 TargetTile, FTileReachabilityEngine& Engine);	// Moves a unit along its cheapest route and spends the movement. False if it cannot stop there.
+
+	void CompleteUnitAction(int32 UnitIndex, bool bAllowMovement, uint8 RemainingMovement);	// Spends an action, as ATileControlPawn::SetUnitActionComplete
+
+	bool IsUnitDone(int32 UnitIndex) const;		// No movement and no actions left
+
+	void ActivateFaction(uint8 Faction);		// Starts a faction's phase - every unit of it gets its base movement and actions back
+
+	bool AdvancePhase();						// Activates the next faction with units in PLAYER -> PARTNER -> ENEMY -> NPC order. False when no unit is left.
+
+	static uint32 GetHostileFactionMask(uint8 Faction);		// Bit (1 << faction) for each faction hostile to this faction
+	static uint32 GetAlliedFactionMask(uint8 Faction);		// Bit (1 << faction) for each faction allied with this faction
+
+protected:
+
+	void SetUnitTile(int32 UnitIndex, int32 TileIndex);		// Moves the occupant records of a unit. INDEX_NONE takes it off the map.
+};
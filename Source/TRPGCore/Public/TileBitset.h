@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Dense set of tile indices with one bit per tile on the map.
+// Membership is O(1), and set operations run a whole 64-bit word at a time in plain loops the compiler can vectorize.
+struct TRPGCORE_API FTileBitset
+{
+public:
+
+	FTileBitset() = default;
+
+	explicit FTileBitset(int32 TileCount) { Init(TileCount); }
+
+	void Init(int32 TileCount);				// Sizes the set for TileCount tiles, all clear
+
+	void Reset();							// Clears every bit and keeps the size
+
+	int32 Num() const { return TileCount; }	// Number of tiles the set can hold
+
+	bool Contains(int32 TileIndex) const
+	{
+		return (uint32)TileIndex < (uint32)TileCount && (Words[TileIndex >> 6] & (1ull << (TileIndex & 63))) != 0;
+	}
+
+	void Add(int32 TileIndex)
+	{
+		checkSlow((uint32)TileIndex < (uint32)TileCount);
+		Words[TileIndex >> 6] |= 1ull << (TileIndex & 63);
+	}
+
+	void Remove(int32 TileIndex)
+	{
+		checkSlow((uint32)TileIndex < (uint32)TileCount);
+		Words[TileIndex >> 6] &= ~(1ull << (TileIndex & 63));
+	}
+
+	void Union(const FTileBitset& Other);		// this |= Other
+	void Intersect(const FTileBitset& Other);	// this &= Other
+	void Difference(const FTileBitset& Other);	// this &= ~Other
+
+	static void Difference(const FTileBitset& A, const FTileBitset& B, FTileBitset& OutResult);	// OutResult = A & ~B
+
+	int32 CountSetBits() const;
+
+	bool IsEmpty() const;
+
+	TArrayView<uint64> GetWords() { return Words; }
+	TConstArrayView<uint64> GetWords() const { return Words; }
+
+	// Calls Func(TileIndex) for every set bit in increasing tile order
+	template<typename FuncType>
+	void ForEachSetBit(FuncType&& Func) const
+	{
+		for (int32 wordIndex = 0; wordIndex < Words.Num(); wordIndex++)
+		{
+			uint64 word = Words[wordIndex];
+			while (word)
+			{
+				const int32 bit = (int32)FMath::CountTrailingZeros64(word);
+				Func((wordIndex << 6) + bit);
+				word &= word - 1;	// clear the lowest set bit
+			}
+		}
+	}
+
+protected:
+
+	TArray<uint64> Words;
+	int32 TileCount = 0;
+};
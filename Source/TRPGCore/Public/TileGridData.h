@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileRowMask.h"
+
+// Neighbor slots stored for every tile. Matches the AGameTile NorthTile/WestTile/EastTile/SouthTile links.
+enum ETileNeighbor : uint8
+{
+	NEIGHBOR_NORTH	= 0,	//  X axis
+	NEIGHBOR_WEST	= 1,	// -Y axis
+	NEIGHBOR_EAST	= 2,	//  Y axis
+	NEIGHBOR_SOUTH	= 3,	// -X axis
+	NEIGHBOR_COUNT	= 4
+};
+
+#define OCCUPANT_FACTION_COUNT 8	// Occupant faction bytes below this value get a cell mask in FTileGridData::FactionCells
+
+// One tile of a baked tile graph. Plain data with explicit padding so a whole array of records serializes as one block.
+struct FTileGraphRecord
+{
+	FIntVector	Coord		= FIntVector::ZeroValue;	// (X, Y, Layer) coordinate
+	int32		Neighbors[NEIGHBOR_COUNT] = { INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE };	// Neighbor record index for each direction
+	uint8		TerrainType	= 255;						// Terrain type byte
+	uint8		Padding[3]	= { 0, 0, 0 };				// Keeps the record size fixed and the serialized bytes deterministic
+
+	friend TRPGCORE_API FArchive& operator<<(FArchive& Ar, FTileGraphRecord& Record);
+};
+
+// Flat structure-of-arrays tile graph. Every tile on the map owns one integer index into each array.
+// Holds no actor or engine types so searches can run on plain indices without touching the tile actors.
+struct TRPGCORE_API FTileGridData
+{
+public:
+
+	TArray<FIntVector>	Coords;							// Integer (X, Y, Layer) coordinate of each tile. X and Y are quantized by the tile spacing, Layer by the vertical range.
+
+	TArray<uint8>		TerrainTypes;					// Terrain type byte of each tile. 255 until the tile reports its terrain.
+
+	TArray<uint8>		OccupantFactions;				// EUnitFaction of the unit standing on each tile. 0 (NO_FACTION) when the tile is empty.
+
+	TArray<int32>		Neighbors[NEIGHBOR_COUNT];		// Neighbor tile index for each direction. INDEX_NONE when there is no neighbor.
+
+	// (X, Y) cell lookup - set by BuildCellLookup(). Tiles on different layers of the same cell are chained through NextTileInCell.
+
+	FIntPoint			GridMin		= FIntPoint::ZeroValue;	// Lowest (X, Y) coordinate of any tile
+	FIntPoint			GridSize	= FIntPoint::ZeroValue;	// Number of X rows and Y columns covering every tile
+
+	TArray<int32>		CellFirstTile;					// First tile index in each cell, or INDEX_NONE
+	TArray<int32>		NextTileInCell;					// Next tile index in the same cell, or INDEX_NONE
+
+	FTileRowMask		FactionCells[OCCUPANT_FACTION_COUNT];	// Cells holding at least one unit of each faction. Kept up to date by SetOccupantFaction().
+
+public:
+
+	void Reset();														// Removes all tiles
+
+	int32 AddTile(const FIntVector& Coord, uint8 TerrainType);			// Adds a tile with no neighbors and returns its index. Call BuildCellLookup() once every tile is added.
+
+	void BuildCellLookup();												// Builds the (X, Y) cell lookup and faction cell masks from the tile coordinates
+
+	int32 GetCell(int32 TileIndex) const								// (X, Y) cell index of a tile - also the bit index in an FTileRowMask over the grid
+	{
+		const FIntVector& coord = Coords[TileIndex];
+		return (coord.X - GridMin.X) * GridSize.Y + (coord.Y - GridMin.Y);
+	}
+
+	void SetOccupantFaction(int32 TileIndex, uint8 Faction);			// Sets the occupant faction byte of a tile and updates the faction cell masks
+
+	bool IsCellOccupied(int32 Cell, uint32 FactionMask) const			// True if the cell holds a unit of any faction in FactionMask (bit 1 << faction)
+	{
+		for (int32 faction = 1; faction < OCCUPANT_FACTION_COUNT; faction++)
+		{
+			if ((FactionMask & (1u << faction)) && FactionCells[faction].Contains(Cell))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Calls Func(TileIndex) for every tile holding a unit of FactionMask whose (X, Y) Manhattan distance to SourceTile is between MinRange and MaxRange.
+	// Only the cells of the diamond ring are visited, each tested against the faction cell masks - the cost is the ring area, not the map size.
+	template<typename FuncType>
+	void ForEachOccupiedTileInRange(int32 SourceTile, int32 MinRange, int32 MaxRange, uint32 FactionMask, FuncType&& Func) const
+	{
+		if (CellFirstTile.IsEmpty() || !IsValidTile(SourceTile))
+		{
+			return;
+		}
+
+		MinRange = FMath::Max(MinRange, 0);
+		const int32 sourceX = Coords[SourceTile].X - GridMin.X;
+		const int32 sourceY = Coords[SourceTile].Y - GridMin.Y;
+		for (int32 x = FMath::Max(sourceX - MaxRange, 0); x <= FMath::Min(sourceX + MaxRange, GridSize.X - 1); x++)
+		{
+			const int32 rowDistance = FMath::Abs(x - sourceX);
+			const int32 minOffset = FMath::Max(MinRange - rowDistance, 0);
+			const int32 maxOffset = MaxRange - rowDistance;
+			for (int32 offset = -maxOffset; offset <= maxOffset; offset++)
+			{
+				const int32 y = sourceY + offset;
+				if (FMath::Abs(offset) < minOffset || y < 0 || y >= GridSize.Y)
+				{
+					continue;
+				}
+
+				const int32 cell = x * GridSize.Y + y;
+				if (!IsCellOccupied(cell, FactionMask))
+				{
+					continue;
+				}
+				for (int32 tile = CellFirstTile[cell]; tile != INDEX_NONE; tile = NextTileInCell[tile])
+				{
+					const uint8 faction = OccupantFactions[tile];	// a cell can stack several layers - only the tiles holding the factions count
+					if (faction != 0 && faction < OCCUPANT_FACTION_COUNT && (FactionMask & (1u << faction)))
+					{
+						Func(tile);
+					}
+				}
+			}
+		}
+	}
+
+	void FindOccupiedTilesInRange(int32 SourceTile, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<int32>& OutTiles) const;	// Appends the tiles ForEachOccupiedTileInRange() visits
+
+	// Batched range query for many source tiles at once. The source cells are dilated by the ring with word-wide row shifts and masked
+	// against the faction cell masks, so the cost does not grow with the number of sources. Each tile is appended once.
+	void FindOccupiedTilesInRange(TConstArrayView<int32> SourceTiles, int32 MinRange, int32 MaxRange, uint32 FactionMask, TArray<int32>& OutTiles) const;
+
+	int32 Num() const { return Coords.Num(); }
+
+	bool IsValidTile(int32 TileIndex) const { return Coords.IsValidIndex(TileIndex); }
+
+	bool HasSameLayout(const FTileGridData& Other) const				// Same tile count and cell bounds - grids built from the same tiles
+	{
+		return Num() == Other.Num() && GridMin == Other.GridMin && GridSize == Other.GridSize;
+	}
+
+	int32 GetNeighbor(int32 TileIndex, ETileNeighbor Direction) const { return Neighbors[Direction][TileIndex]; }
+
+	bool GetAreAdjacent(int32 TileA, int32 TileB, ETileNeighbor& DirectionFromA) const;	// Returns true if TileB is a neighbor of TileA
+
+	static ETileNeighbor GetOppositeNeighbor(ETileNeighbor Direction);	// North <-> South, West <-> East
+
+	void ExportRecords(TArray<FTileGraphRecord>& OutRecords) const;		// Packs the tile coordinates, terrain and neighbors into one contiguous array
+
+	void ImportRecords(const TArray<FTileGraphRecord>& Records);		// Replaces all tiles with the baked records and builds the cell lookup. Every tile starts unoccupied.
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileGridData.h"
+#include "TileBitset.h"
+
+// Input for one path query between two tiles
+struct FTilePathQuery
+{
+	int32	FromTile	= INDEX_NONE;		// Tile the path continues from (not part of the returned path)
+	int32	ToTile		= INDEX_NONE;		// Tile the path must end on
+
+	int32	MoveBudget	= 0;				// Most movement the path may spend. Entering a tile costs the move cost of its terrain.
+
+	TConstArrayView<uint8> MoveCosts;		// Move cost for each of the 256 terrain type bytes. 255 is impassable.
+
+	TConstArrayView<uint8> TileCosts;		// Move cost of each tile by tile index (UTileGridSubsystem::GetMoveCostGrid). Used instead of MoveCosts when set.
+
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> TileCostsOwner;	// Keeps shared TileCosts alive for as long as the query is
+
+	const FTileBitset* AllowedTiles		= nullptr;	// Tiles the path may use - normally the navigable tiles. nullptr allows every tile.
+	const FTileBitset* ExcludedTiles	= nullptr;	// Tiles the path may not use - normally the path already planned
+
+	ETileNeighbor DirectionPriority[NEIGHBOR_COUNT] = { NEIGHBOR_NORTH, NEIGHBOR_SOUTH, NEIGHBOR_EAST, NEIGHBOR_WEST };	// Tie-break between equally cheap steps, first is preferred
+
+	void SetTileCosts(const TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>& Costs) { TileCostsOwner = Costs; TileCosts = *Costs; }
+
+	bool HasMoveCosts(const FTileGridData& Grid) const { return TileCosts.Num() == Grid.Num() || MoveCosts.Num() >= 256; }
+
+	uint8 GetTileCost(const FTileGridData& Grid, int32 TileIndex) const	// Cost of entering a tile
+	{
+		return TileCosts.Num() ? TileCosts[TileIndex] : MoveCosts[Grid.TerrainTypes[TileIndex]];
+	}
+};
+
+// Cheapest-path search between two tiles of FTileGridData.
+// FindPath runs A* backwards from the target with a bucket queue and a Manhattan heuristic, bounded by the move budget, which gives every
+// explored tile its exact remaining cost to the target. The path is then walked forwards from the start, taking the first step
+// in DirectionPriority that stays on a cheapest route, so ties always resolve the same way.
+class TRPGCORE_API FTilePathPlanner
+{
+public:
+
+	// Fills OutPath with the tiles after FromTile up to and including ToTile. Returns false if no path fits in the budget.
+	bool FindPath(const FTileGridData& Grid, const FTilePathQuery& Query, TArray<int32>& OutPath, int32& OutCost);
+
+	// Re-plans a drawn path to reach ToTile, keeping the longest prefix of Path that still fits in the budget. The detour may not cross
+	// its prefix but may reuse the dropped tail of the path. One backward search from ToTile labels each tile with its cost to the target
+	// and the lowest path index its route passes through, so every prefix split is priced by the same search.
+	// Path starts on the unit's tile. MoveBudget is the budget for the whole path; Query.ExcludedTiles is ignored.
+	// On success the new path is the first OutPrefixLength tiles of Path followed by OutDetour.
+	bool FindPathKeepingPrefix(const FTileGridData& Grid, const FTilePathQuery& Query, TConstArrayView<int32> Path, int32& OutPrefixLength, TArray<int32>& OutDetour);
+
+	static void GetCameraDirectionPriority(bool bCameraFacesNorthOrSouth, ETileNeighbor (&OutPriority)[NEIGHBOR_COUNT]);	// Horizontal-on-screen steps first, matching the top-down diagonal view
+
+protected:
+
+	void PrepareScratch(int32 TileCount, int32 MoveBudget);
+
+	bool WalkCheapestPath(const FTileGridData& Grid, const FTilePathQuery& Query, int32 FromTile, TArray<int32>& OutPath) const;	// Follows RemainingCosts from FromTile to Query.ToTile
+
+	bool IsTileAllowed(const FTilePathQuery& Query, int32 TileIndex) const;
+
+	int32 FindPrefixLabel(int32 TileIndex, int32 Cost, int32 MinLevel) const;	// Settled label of FindPathKeepingPrefix on a tile, or INDEX_NONE
+
+	int32 GetHeuristic(const FTileGridData& Grid, int32 TileIndex, int32 GoalTile, int32 MinMoveCost) const;	// Manhattan distance times the cheapest move cost - never overestimates
+
+protected:
+
+	TArray<uint32>	Stamps;				// Search stamp of each tile whose RemainingCosts entry is current
+	TArray<uint16>	RemainingCosts;		// Cheapest known cost from a tile to the target
+	uint32			Stamp = 0;
+
+	TArray<TArray<int32>> Buckets;		// Buckets[Cost + Heuristic]
+
+	// FindPathKeepingPrefix search state. A label is a route from a tile to the target: its cost, and its level - the lowest path
+	// index the route passes through, or the path length if none. The route is a valid detour for every prefix split up to its level.
+	struct FPrefixLabel
+	{
+		int32	Tile;
+		int32	Cost;
+		int32	Level;
+		int32	NextOnTile;		// Next settled label of the same tile
+	};
+
+	TArray<FPrefixLabel>	Labels;			// Every label pushed by the current search. Buckets hold their indices.
+	TArray<int32>			TileLevels;		// Highest level settled on each tile - lower levels arriving later are dominated
+	TArray<int32>			FirstLabels;	// First settled label of each tile
+	TArray<int32>			PathIndices;	// Index of each tile in the path being re-planned, or INDEX_NONE
+	TArray<int32>			PrefixCosts;	// Cost of walking the path up to each index
+};
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileGridData.h"
+
+#define BLOCKED_MOVE_COST 255	// Move cost that marks a terrain type as impassable
+
+// Input for one reachability search from a unit's tile
+struct FTileReachabilityQuery
+{
+	int32	StartTile		= INDEX_NONE;	// Tile index the unit is standing on
+
+	int32	MoveBudget		= 0;			// Remaining movement. Entering a tile costs the move cost of that tile's terrain.
+
+	TConstArrayView<uint8> MoveCosts;		// Move cost for each of the 256 terrain type bytes. BLOCKED_MOVE_COST is impassable.
+
+	TConstArrayView<uint8> TileCosts;		// Move cost of each tile by tile index (UTileGridSubsystem::GetMoveCostGrid). Used instead of MoveCosts when set.
+
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> TileCostsOwner;	// Keeps shared TileCosts alive for as long as the query is
+
+	uint32	HostileFactions	= 0;			// Bit (1 << faction) for each occupant faction that blocks movement and can be attacked
+	uint32	AlliedFactions	= 0;			// Bit (1 << faction) for each occupant faction that can be interacted with
+
+	uint8	MinActRange		= 0;			// Weapon range as Manhattan distance on the (X, Y) grid from any tile the unit can stop on
+	uint8	MaxActRange		= 0;
+
+	bool	bTargetsEnemies	= false;		// Weapon can target hostile units
+	bool	bTargetsAllies	= false;		// Weapon can target allied units
+
+	bool	bCollectRangeTiles	= false;	// Also list every tile in weapon range, occupied or not (threat displays)
+
+	void SetTileCosts(const TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>& Costs) { TileCostsOwner = Costs; TileCosts = *Costs; }
+
+	bool HasMoveCosts(const FTileGridData& Grid) const { return TileCosts.Num() == Grid.Num() || MoveCosts.Num() >= 256; }
+
+	uint8 GetTileCost(const FTileGridData& Grid, int32 TileIndex) const	// Cost of entering a tile
+	{
+		return TileCosts.Num() ? TileCosts[TileIndex] : MoveCosts[Grid.TerrainTypes[TileIndex]];
+	}
+};
+
+// Output of a reachability search. Tiles are stored sparsely in the order they were settled, so the result only grows with the range.
+struct TRPGCORE_API FTileReachabilityResult
+{
+public:
+
+	TArray<int32>	NavigableTiles;		// Every tile the unit can move onto or through, in increasing distance order. The start tile is first.
+	TArray<uint16>	Distances;			// Movement spent to reach each navigable tile
+	TArray<int32>	Predecessors;		// Previous tile index on the cheapest route to each navigable tile. INDEX_NONE for the start tile.
+
+	TArray<int32>	AttackableTiles;	// Hostile-occupied tiles in weapon range of a tile the unit can stop on
+	TArray<int32>	InteractableTiles;	// Ally-occupied tiles in weapon range of a tile the unit can stop on
+
+	TArray<int32>	RangeTiles;			// Every tile in weapon range of a tile the unit can stop on. Only filled with bCollectRangeTiles.
+
+	TMap<int32, int32> TileSlots;		// Tile index -> position in NavigableTiles / Distances / Predecessors
+
+public:
+
+	void Reset();
+
+	bool IsNavigable(int32 TileIndex) const { return TileSlots.Contains(TileIndex); }
+
+	int32 GetDistance(int32 TileIndex) const;		// Movement spent to reach a tile, or INDEX_NONE if it cannot be reached
+
+	int32 GetPredecessor(int32 TileIndex) const;	// Previous tile on the cheapest route, or INDEX_NONE
+
+	void GetPathTo(int32 TileIndex, TArray<int32>& OutPath) const;	// Cheapest route from the start tile to a tile, start tile first. Empty if unreachable.
+};
+
+// Movement and weapon range search over FTileGridData.
+// Movement uses Dijkstra with a bucket queue (Dial's algorithm): move costs are small integers, so the queue is one bucket per
+// distance and every push/pop is O(1). The whole search is linear in the number of tiles in range.
+// Weapon range is a separate pass: the tiles the unit can stop on are packed into a row mask, dilated by the weapon's
+// min/max diamond ring with word-wide row shifts, and masked against the faction cell masks. Its cost does not grow with the number of tiles in range.
+// Scratch arrays are kept between searches and stamped per search, so nothing is cleared per tile on the map.
+class TRPGCORE_API FTileReachabilityEngine
+{
+public:
+
+	void Compute(const FTileGridData& Grid, const FTileReachabilityQuery& Query, FTileReachabilityResult& OutResult);
+
+protected:
+
+	void PrepareScratch(int32 TileCount);
+
+	bool IsStandingTile(const FTileGridData& Grid, const FTileReachabilityQuery& Query, int32 TileIndex) const;	// Reached and empty - the unit can stop and act here
+
+	void CollectTargetsInRange(const FTileGridData& Grid, const FTileReachabilityQuery& Query, uint32 TargetFactions, TArray<int32>& OutTargets) const;	// Tiles in RangeCells holding a unit of TargetFactions
+
+	void ComputeActionTargets(const FTileGridData& Grid, const FTileReachabilityQuery& Query, FTileReachabilityResult& OutResult);
+
+protected:
+
+	TArray<uint32>	MoveStamps;			// Search stamp of each tile whose MoveDistances/MovePredecessors entry is current
+	TArray<uint16>	MoveDistances;
+	TArray<int32>	MovePredecessors;
+	uint32			MoveStamp = 0;
+
+	TArray<TArray<int32>> Buckets;		// Dial buckets - Buckets[Distance] holds tiles queued at that distance
+
+	FTileRowMask	StandingCells;		// Cells the unit can stop on
+	FTileRowMask	RangeCells;			// Cells within weapon range of a standing cell
+};
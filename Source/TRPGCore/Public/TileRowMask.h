@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Bitmask over the (X, Y) cells of the tile grid. Each X row is packed into 64-bit words along Y,
+// so whole rows can be shifted and combined a word at a time.
+// Cell index = (X - GridMin.X) * GridSize.Y + (Y - GridMin.Y), matching FTileGridData::GetCell().
+struct TRPGCORE_API FTileRowMask
+{
+public:
+
+	void Init(const FIntPoint& InSize);		// Size.X rows of Size.Y bits, all clear
+
+	void Reset();							// Clears every bit and keeps the size
+
+	FIntPoint GetSize() const { return Size; }
+
+	int32 GetWordsPerRow() const { return WordsPerRow; }
+
+	bool Contains(int32 Cell) const
+	{
+		return (uint32)Cell < (uint32)(Size.X * Size.Y) && (Words[GetWordIndex(Cell)] & GetBit(Cell)) != 0;
+	}
+
+	void Add(int32 Cell)	{ Words[GetWordIndex(Cell)] |= GetBit(Cell); }
+
+	void Remove(int32 Cell)	{ Words[GetWordIndex(Cell)] &= ~GetBit(Cell); }
+
+	uint64* GetRow(int32 Row)				{ return Words.GetData() + Row * WordsPerRow; }
+	const uint64* GetRow(int32 Row) const	{ return Words.GetData() + Row * WordsPerRow; }
+
+	// Sets every cell whose Manhattan distance to a set cell of Source is between MinRange and MaxRange.
+	// Each source row is OR-ed into the rows within MaxRange, shifted along Y by every offset the diamond ring allows at that row distance.
+	static void DilateAnnulus(const FTileRowMask& Source, int32 MinRange, int32 MaxRange, FTileRowMask& OutResult);
+
+	// Calls Func(Cell) for every cell set in both masks. The masks must be the same size.
+	template<typename FuncType>
+	static void ForEachSetBitInBoth(const FTileRowMask& A, const FTileRowMask& B, FuncType&& Func)
+	{
+		check(A.Size == B.Size);
+		for (int32 row = 0; row < A.Size.X; row++)
+		{
+			const uint64* rowA = A.GetRow(row);
+			const uint64* rowB = B.GetRow(row);
+			for (int32 wordIndex = 0; wordIndex < A.WordsPerRow; wordIndex++)
+			{
+				uint64 word = rowA[wordIndex] & rowB[wordIndex];
+				while (word)
+				{
+					const int32 column = (wordIndex << 6) + (int32)FMath::CountTrailingZeros64(word);
+					Func(row * A.Size.Y + column);
+					word &= word - 1;	// clear the lowest set bit
+				}
+			}
+		}
+	}
+
+protected:
+
+	int32 GetWordIndex(int32 Cell) const	{ return (Cell / Size.Y) * WordsPerRow + ((Cell % Size.Y) >> 6); }
+
+	uint64 GetBit(int32 Cell) const			{ return 1ull << ((Cell % Size.Y) & 63); }
+
+	static void OrShiftedRow(const uint64* SourceRow, uint64* DestRow, int32 WordCount, int32 Shift);	// DestRow |= SourceRow shifted toward +Y by Shift bits (negative shifts toward -Y)
+
+	void ClearRowTails();					// Clears bits past Size.Y that row shifts carried into the last word of each row
+
+protected:
+
+	FIntPoint		Size		= FIntPoint::ZeroValue;
+	int32			WordsPerRow	= 0;
+	TArray<uint64>	Words;
+};
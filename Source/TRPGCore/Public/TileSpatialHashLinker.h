@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TileGridData.h"
+
+// Links every tile to its neighbors without collision queries.
+// Tile locations are bucketed in a hash keyed by position quantized by the tile spacing and banded on Z by the vertical range,
+// so each neighbor lookup is a single bucket probe and the whole map links in one pass.
+struct TRPGCORE_API FTileSpatialHashLinker
+{
+public:
+
+	// Fills OutNeighbors[Direction][TileIndex] for every tile. Tiles without a neighbor in a direction get INDEX_NONE.
+	// Spacings and VerticalRanges are the AdjacentTileDistance and AdjacentTileVerticalRange of each tile.
+	static void LinkTiles(TConstArrayView<FVector> Locations, TConstArrayView<float> Spacings, TConstArrayView<float> VerticalRanges, TArray<int32> (&OutNeighbors)[NEIGHBOR_COUNT]);
+
+	static FVector GetNeighborOffset(ETileNeighbor Direction, float Spacing);	// Offset from a tile to the center of its neighbor in a direction
+};
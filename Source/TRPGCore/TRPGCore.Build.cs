@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+// Tile grid, search and battle rule algorithms. Depends only on Core so it builds into the TRPG game module
+// and into the TRPGCoreBench program without the engine.
+public class TRPGCore : ModuleRules
+{
+	public TRPGCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}